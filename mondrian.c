@@ -1,7 +1,22 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 
 #define MP_SIZE 2
 #define P_MUL 10
@@ -11,24 +26,191 @@
 #define OPTIONS_MIN 2
 #define NOT_ENOUGH_TILES 2
 #define TILE_LOCKED 2
+#define TILE_PLACED 3
+#define PROBES_SEED 1
+#define PROBE_NODES_MAX 1000000UL
+#define BUDGET_CHECK_NODES 65536UL
+#define MEMO_INTS 4194304
+#define MEMO_KEY 4
+#define NOGOODS_MIN 1024
+#define NOGOODS_MAX 1048576
+#define CONFLICTS_MIN 1024
+#define CONFLICTS_MAX 4194304
+#define CONFLICTS_TILES_MAX 256
+#define CONFLICT_BITS (int)(sizeof(unsigned long)*CHAR_BIT)
+#define OPTION_BITS (int)(sizeof(unsigned long)*CHAR_BIT)
+#define PRUNE_BARS 0
+#define PRUNE_Y_SLOT 1
+#define PRUNE_X_MAX 2
+#define PRUNE_OPTION 3
+#define PRUNE_BAR 4
+#define PRUNE_LAST_CHANCE 5
+#define PRUNE_X_SLOT 6
+#define PRUNE_CORNER 7
+#define PRUNE_COUNT 8
+#define PRUNE_AREA 9
+#define PRUNE_SYM 10
+#define PRUNE_DEFECT 11
+#define PRUNE_OVERFLOW 12
+#define PRUNE_NOGOOD 13
+#define PRUNE_CONFLICT 14
+#define PRUNES_N 15
+#define PHASE_SETS 0
+#define PHASE_Y 1
+#define PHASE_X 2
+#define PHASES_N 3
+#define BRANCHES_MAX 16
+#define JSON_BUFFER_SIZE (size_t)1048576
+#define JSON_FLUSH_SECONDS 1.0
+#define SPLIT_DEPTH 3
+#define PREFIXES_MIN 1024
+#define UNIT_NAME_SIZE 32
+#define MERGE_LINE_SIZE 256
+#define STATUS_SIZE 16
+#define REQUEST_LINE_SIZE 256
+#define LEVEL_BUFFER_SIZE (size_t)4096
+#define SERVER_BACKLOG 64
+#define STORE_MAGIC 0x4d4f4e44
+#define STORE_VERSION 1
+#define STORE_HEADER_SIZE 2
+#define RECORD_MAGIC 0x52454344
+#define RECORD_HEADER_SIZE 9
+#define RECORD_EXHAUSTED 1
+#define RECORD_TILING 2
+#define CHECKSUM_MUL 31U
+#define IMPORT_LINE_SIZE 256
+#define TILINGS_SLOTS_MIN (size_t)1024
+#define TILINGS_WORDS_MIN (size_t)4096
+#define TRANSFORMS_SQUARE 8
+#define TRANSFORMS_RECTANGLE 4
+#define TRANSFORM_FLIP_Y 1
+#define TRANSFORM_FLIP_X 2
+#define TRANSFORM_TRANSPOSE 4
+
+#ifdef MONDRIAN_TELEMETRY
+#define TELEMETRY(statement) statement
+#else
+#define TELEMETRY(statement)
+#endif
+
+#ifdef MONDRIAN_LEAN
+#define AREA_MAX LONG_MAX
+#define COUNTS_MIN 1024
+typedef long area_t;
+#else
+#define AREA_MAX INT_MAX
+typedef int area_t;
+#endif
 
 typedef struct {
 	int height;
 	int width;
-	int area;
+	area_t area;
 	int delta;
-	int slots_n;
+	unsigned long slots_n;
 	int rotate_flag;
+	unsigned long areas_sum;
+	int nogood;
+	int conflict;
 }
 tile_t;
 
+typedef struct {
+	int height;
+	int width;
+	double nodes;
+	double seconds;
+}
+paint_t;
+
+typedef struct {
+	int defect;
+	int options;
+	int unit;
+	double nodes;
+}
+prefix_t;
+
+typedef struct {
+	int y_slot;
+	int x_slot;
+	int height;
+	int width;
+	int locked_flag;
+}
+place_t;
+
+typedef struct {
+	int height;
+	int width;
+	int rotate_flag;
+	int kind;
+	int defect_lo;
+	int defect_hi;
+	int tiles_n;
+	const int *tiles;
+}
+record_t;
+
+typedef struct {
+	unsigned long tiles_n;
+	unsigned long sets_n;
+	unsigned long packs_n;
+	unsigned long memos_n;
+	unsigned long nogoods_n;
+	unsigned long locks_n;
+	unsigned long y_nodes_n;
+	unsigned long x_nodes_n;
+	double tiles_seconds;
+	double sets_seconds;
+	double packs_seconds;
+	double y_seconds;
+	double x_seconds;
+}
+stats_t;
+
+typedef struct {
+	int r;
+	int options;
+	int timeout_flag;
+	int exhausted_flag;
+	int places_defect;
+	int places_n;
+	unsigned long tilings_n;
+	unsigned long nodes_n;
+	stats_t stats;
+}
+outcome_t;
+
+typedef struct {
+	pid_t pid;
+	FILE *output;
+	FILE *outcomes;
+	outcome_t outcome;
+}
+level_t;
+
+#ifdef MONDRIAN_LEAN
+typedef struct {
+	area_t area;
+	int count;
+}
+count_t;
+#endif
+
+typedef struct {
+	area_t lo;
+	area_t hi;
+}
+window_t;
+
 typedef struct option_s option_t;
 
 struct option_s {
 	int height;
 	int width;
-	int area;
-	int slots_n;
+	area_t area;
+	unsigned long slots_n;
 	int rotate_flag;
 	int yh_slot_max;
 	int yw_slot_max;
@@ -39,6 +221,7 @@ struct option_s {
 	int x_slot_max;
 	int x_slot_lo;
 	int x_slot_hi;
+	unsigned long bit;
 	option_t *y_last;
 	option_t *y_next;
 	option_t *x_last;
@@ -55,6 +238,13 @@ struct bar_s {
 	bar_t *next;
 };
 
+typedef struct {
+	int y_slot;
+	int width;
+	int x_slot_lo;
+}
+ledge_t;
+
 typedef struct choice_s choice_t;
 
 struct choice_s {
@@ -64,35 +254,129 @@ struct choice_s {
 	choice_t *next;
 };
 
+static int read_option(int, char *[], int *, long, long, long *);
+static int read_path(int, char *[], int *, const char **);
+static int run_requests(int, int, int);
+static int run_paint(const char *);
 static int run_request(const char *);
+static int search_levels(int *);
+static int start_level(level_t *, int);
+static void run_level(level_t *, int);
+static int wait_level(level_t *);
+static int read_level(level_t *, int *);
+static void stop_levels(level_t *);
+static int run_split(void);
+static int print_segments(int, FILE *, double *);
+static int read_unit(int *, int *);
+static int run_work(void);
+static int run_merge(int, char *[]);
+static int is_valid_request(int, int);
+static int run_server(void);
+static pid_t start_worker(int);
+static int serve_requests(void);
+static void stop_server(int);
+static int open_store(void);
+static int index_store(void);
+static int refresh_store(void);
+static int scan_store(record_t *);
+static int get_checksum(const int *, const int *);
+static void lookup_store(int *, const record_t **);
+static int bound_store(int *, const record_t **);
+static int compare_record_key(const record_t *);
+static int append_record(int, int, int, int, int, int, int, const place_t *);
+static void print_known(const char *, const record_t *);
+static int set_pair_places(const record_t *);
+static void print_places(void);
+static int is_in_defects(int);
+static void close_store(void);
+static int run_import(void);
+static int import_achievements(FILE *);
+static int import_view(FILE *);
+static int import_exhausted(int, int, int, int, int);
+static int is_symbol_row(const char *, int, int);
+static int add_import(int, int, int, int);
+static int import_tiling(int, int, int);
+static int alloc_paint(void);
+static int estimate_paint(paint_t *);
+static int estimate_defect(double *, double *);
+static double probe_mondrian_tile(int, int, double);
 static int search_defect(void);
-static int is_valid_area(int);
-static int check_defect(int, int, int);
-static int check_area_div(int, int);
-static int is_valid_tile(int);
-static int check_tile1(int, int, int);
-static int check_tile2(int, int, int, int, int);
-static int check_big_tile1(int, int, int, int);
-static int check_big_tile2(int, int, int);
-static void check_count(int);
+static int check_bounds(void);
+static int set_tiles(void);
+static void set_bounds(void);
+static void set_windows(void);
+static int next_height(int, int);
+static void clear_counts(void);
+static void add_count(area_t);
+static int get_count(area_t);
+static int check_counts(void);
+static int is_valid_area(area_t);
+static int check_defect(area_t, area_t, int);
+static area_t check_area_div(area_t, area_t);
+static int is_valid_tile(area_t);
+static int check_tile1(int, int, area_t);
+static int check_tile2(area_t, int, int, int, int);
+static int check_big_tile1(int, int, int, area_t);
+static int check_big_tile2(int, area_t, int);
 static void add_tile(int, int);
+static unsigned long sum_tiles(int, int);
 static int add_mondrian_tile(int, int);
+static int visit_prefix(int, int);
+static int grow_prefixes(void);
+static int check_mondrian_tile(int, int *);
+static int is_nogood(int);
+static void set_conflicts(void);
+static int grow_conflicts(int);
+static int grow_compats(int);
+static int add_conflict(int, int);
+static void push_conflicts(int);
+static int check_conflicts(int);
+static int is_conflict(int);
 static int is_mondrian(void);
+static void set_core(tile_t *, tile_t *);
+static int is_core(void);
+static int check_core(tile_t **, int, int);
+static int can_fit(const tile_t *, int, int);
+static int can_share(const tile_t *, const tile_t *, int, int);
+static void add_nogood(void);
+static int *get_memo(void);
+static int is_memo(const int *);
+static void set_memo(int *);
 static int can_rotate(const tile_t *);
 static int can_be_locked(tile_t *);
 static void release_locks(void);
 static void print_solution(void);
 static void print_lock(const tile_t *);
-static int search_y_slot(int, bar_t *, option_t *);
+static void set_places(void);
+static void clear_tilings(void);
+static void add_tiling(void);
+static void set_tiling_words(int *);
+static int compare_tiling_words(const int *, const int *, int);
+static int insert_tiling(size_t);
+static int grow_tilings_slots(void);
+static void print_json(const char *, const paint_t *, int, int, int, unsigned long, double);
+static int search_y_slot_rotate(int, bar_t *, option_t *);
+static int search_y_slot_fixed(int, bar_t *, option_t *);
 static int check_next_y_slot(bar_t *, int);
-static int choose_y_slot(int, bar_t *, option_t *, int, int);
+static int choose_y_slot_rotate(int, bar_t *, option_t *, int, int);
+static int choose_y_slot_fixed(int, bar_t *, option_t *, int, int);
 static void rollback_y_slot(bar_t *, bar_t *, bar_t *, int, int);
 static int search_x_slot(choice_t *);
-static int is_valid_choice(const option_t *, int, int);
 static void add_choice(int, int);
 static void mp_new(int []);
 static void mp_inc(int []);
 static void mp_print(const char *, const int []);
+static void set_stats(void);
+static void add_stats(const stats_t *);
+static void print_stats(unsigned long, double);
+static void set_paint(paint_t *, int, int);
+static void set_place(place_t *, int, int, int, int, int);
+static void set_prefix(prefix_t *, int, int, double);
+static int compare_paints(const void *, const void *);
+static void set_record(record_t *, const int *);
+static int compare_records(const void *, const void *);
+static void set_symmetric_place(place_t *, const place_t *, int);
+static int compare_places(const void *, const void *);
 static void set_tile(tile_t *, int, int);
 static int compare_tiles(const void *, const void *);
 static void copy_tile(option_t *, const tile_t *);
@@ -104,241 +388,2072 @@ static void print_option(const option_t *);
 static void set_bar(bar_t *, int, int, int);
 static void insert_bar(bar_t *, bar_t *, bar_t *);
 static void link_bars(bar_t *, bar_t *);
+static void set_ledge(int, int, int);
+static void set_fits(void);
+static void set_rows(void);
+static unsigned long get_fits(int, int);
+static unsigned long get_low_mask(int);
+static int get_low_bit(unsigned long);
+static int can_fill_rotate(const bar_t *);
+static int can_fill_fixed(const bar_t *);
+static option_t *get_x_option(option_t *, int);
 static void set_choice(choice_t *, int, int);
 static int compare_choices(const choice_t *, const choice_t *);
 static void insert_choice(choice_t *, choice_t *, choice_t *);
 static void link_choices(choice_t *, choice_t *);
+static void set_budget(unsigned long, int);
+static void set_nodes_limit(unsigned long);
+static int is_in_budget(void);
+#ifdef MONDRIAN_LEAN
+static int compare_counts(const void *, const void *);
+#endif
+#ifdef MONDRIAN_TELEMETRY
+static void set_telemetry(void);
+static void add_prune(int, int);
+static void add_branch(int, int);
+static void set_branches(int, int);
+static void close_branches(int, int);
+static void print_telemetry(void);
+#endif
+static double get_time(void);
 static void flush_log(FILE *, const char *, ...);
+static int alloc_data(void);
 static void free_data(void);
 
-static int rotate_flag, defect_a, defect_b, options_lo, options_hi, verbose_flag, p_max, p_len, tiles_max, paint_height, paint_width, paint_area, *counts, defect_cur, options_cur, tiles_n, mondrian_tiles_n, tile_stop, tiles_area, mondrian_defect, height_max, width_max, options_n, y_cost[MP_SIZE], bars_n, solutions_n, x_cost[MP_SIZE];
+static int options_max, split_units, split_probes, merge_idx, unit_idx, units_n, segments_n, prefix_depth, prefix_lo, prefix_hi, prefixes_n, prefixes_max, json_flag, estimate_probes, schedule_probes, probes_n, workers_n, worker_idx, stats_flag, budget_seconds, timeout_flag, rotate_flag, defect_a, defect_b, options_lo, options_hi, verbose_flag, p_max, p_len, tiles_max, paint_height, paint_width, defect_cur, options_cur, tiles_n, mondrian_tiles_n, tile_stop, mondrian_defect, height_max, width_max, options_n, y_cost[MP_SIZE], bars_n, solutions_n, x_cost[MP_SIZE], frame_height, frame_width, places_n, places_max, places_defect, store_fd, records_n, view_rotate_flag, imports_n, imports_max, imported_n, count_flag, tilings_error, pair_flag, pair_lower, pair_upper, pair_defect, levels_n;
+static area_t paint_area, tiles_area;
+static unsigned long budget_nodes, nodes_n, nodes_max, nodes_limit, tilings_n;
+static double probes_tilings, time_limit, json_time;
+static stats_t stats;
+static size_t store_size, tilings_slots_n, tilings_words_n, tilings_words_max;
+static const char *split_path, *work_path, *merge_path, *server_path, *store_path, *import_path, *view_path;
+static volatile sig_atomic_t server_stop_flag;
+
+#ifdef MONDRIAN_TELEMETRY
+static const char *prunes_names[PRUNES_N] = { "bars", "y_slot", "x_max", "option", "bar", "last_chance", "x_slot", "corner", "count", "area", "sym", "defect", "overflow", "nogood", "conflict" }, *phases_names[PHASES_N] = { "sets", "y", "x" };
+static int depths_n, y_depth, *branches;
+static unsigned long *prunes, *histograms;
+#endif
+#ifdef MONDRIAN_LEAN
+static int counts_n, counts_max, counts_error, counts_idx;
+static count_t *counts;
+#else
+static int *counts;
+#endif
+static int windows_n, bound_defect, bound_options, bound_lo, bound_hi;
+static window_t *windows;
 static tile_t *tiles, **mondrian_tiles;
 static option_t *options, **solutions, *options_header, *option_sym;
 static bar_t *bars, *bars_header;
+static ledge_t *ledges;
+static int masks_flag, fits_n;
+static unsigned long y_options, x_options, *width_fits, *height_fits, *yh_fits, *yw_fits, *y_rows;
 static choice_t *choices, *choices_header, *choices_hi;
+static int memo_ints, memos_n, *memos, nogoods_n, nogoods_max, *nogoods, cores_n, conflicts_words, conflicts_n, conflicts_max, compats_max, *compat_counts;
+static unsigned long *conflicts, *conflicts_mask, *compat_areas;
+static tile_t **cores;
+static place_t *places, *imports, *tiling_places;
+static int *store_words, *tilings_words, *tiling_words;
+static size_t *tilings_slots;
+static record_t *records;
+static prefix_t *prefixes;
 
-int main(void) {
-	int request, order_lo, order_hi, choices_n;
-	if (scanf("%d%d%d%d%d%d%d%d%d", &request, &order_lo, &order_hi, &rotate_flag, &defect_a, &defect_b, &options_lo, &options_hi, &verbose_flag) != 9 || order_lo < 1 || order_lo > order_hi || (unsigned)order_lo > SIZE_T_MAX/(unsigned)order_hi || defect_a < 0 || defect_b < 0 || options_lo < OPTIONS_MIN || options_lo > options_hi) {
-		flush_log(stderr, "Expected parameters: request (%d = squares / %d = rectangles / other = unique), order_lo (>= 1), order_hi (>= order_lo), rotate_flag, defect_a (>= 0), defect_b (>= 0), options_lo (>= %d), options_hi (>= options_lo), verbose_flag.\n", REQUEST_SQUARES, REQUEST_RECTANGLES, OPTIONS_MIN);
+int main(int argc, char *argv[]) {
+	int request, order_lo, order_hi, workers_flag = 0, r, i;
+	workers_n = 1;
+	pair_lower = -1;
+	pair_upper = -1;
+	pair_defect = -1;
+	for (i = 1; i < argc; ++i) {
+		long value;
+		if (!strcmp(argv[i], "-e")) {
+			r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+			estimate_probes = (int)value;
+		}
+		else if (!strcmp(argv[i], "-l")) {
+			r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+			schedule_probes = (int)value;
+		}
+		else if (!strcmp(argv[i], "-w")) {
+			r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+			workers_n = (int)value;
+			if (r) {
+				r = read_option(argc, argv, &i, 0L, (long)workers_n-1L, &value);
+				worker_idx = (int)value;
+			}
+			workers_flag = 1;
+		}
+		else if (!strcmp(argv[i], "-s")) {
+			stats_flag = 1;
+			r = 1;
+		}
+		else if (!strcmp(argv[i], "-t")) {
+			r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+			budget_seconds = (int)value;
+		}
+		else if (!strcmp(argv[i], "-n")) {
+			r = read_option(argc, argv, &i, 1L, LONG_MAX, &value);
+			budget_nodes = (unsigned long)value;
+		}
+		else if (!strcmp(argv[i], "-j")) {
+			json_flag = 1;
+			r = 1;
+		}
+		else if (!strcmp(argv[i], "-c")) {
+			count_flag = 1;
+			r = 1;
+		}
+		else if (!strcmp(argv[i], "-B")) {
+			pair_flag = 1;
+			r = 1;
+		}
+		else if (!strcmp(argv[i], "-P")) {
+			r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+			levels_n = (int)value;
+		}
+		else if (!strcmp(argv[i], "-S")) {
+			r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+			split_units = (int)value;
+			if (r) {
+				r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+				split_probes = (int)value;
+			}
+			if (r) {
+				r = read_path(argc, argv, &i, &split_path);
+			}
+		}
+		else if (!strcmp(argv[i], "-W")) {
+			r = read_path(argc, argv, &i, &work_path);
+		}
+		else if (!strcmp(argv[i], "-D")) {
+			r = read_path(argc, argv, &i, &server_path);
+			if (r) {
+				r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+				workers_n = (int)value;
+			}
+			json_flag = 1;
+		}
+		else if (!strcmp(argv[i], "-R")) {
+			r = read_path(argc, argv, &i, &store_path);
+		}
+		else if (!strcmp(argv[i], "-I")) {
+			r = read_path(argc, argv, &i, &import_path);
+		}
+		else if (!strcmp(argv[i], "-V")) {
+			r = read_path(argc, argv, &i, &view_path);
+			if (r) {
+				r = read_option(argc, argv, &i, 0L, 1L, &value);
+				view_rotate_flag = (int)value;
+			}
+		}
+		else if (!strcmp(argv[i], "-M")) {
+			r = read_path(argc, argv, &i, &merge_path);
+			merge_idx = i;
+			i = argc;
+		}
+		else {
+			r = 0;
+		}
+		if (!r) {
+			flush_log(stderr, "Expected options: -e probes (>= 1), -l probes (>= 1), -w workers_n (>= 1) worker_idx (>= 0 and < workers_n), -t seconds (>= 1), -n nodes (>= 1), -s, -j, -c, -B, -P levels (>= 1), -S units (>= 1) probes (>= 1) path, -W path, -M path [ path ... ], -D path workers (>= 1), -R path, -I path, -V path rotate_flag (0 or 1).\n");
+			return EXIT_FAILURE;
+		}
+	}
+	if ((split_units && (work_path || merge_path)) || (work_path && merge_path) || ((split_units || work_path || merge_path) && (estimate_probes || schedule_probes || json_flag || server_path || store_path))) {
+		flush_log(stderr, "Options -S, -W, -M and -D exclude each other, options -S, -W and -M exclude options -e, -l, -j, -R.\n");
 		return EXIT_FAILURE;
 	}
-	for (p_max = 1, p_len = 0; p_max <= INT_MAX/P_MUL; p_max *= P_MUL, ++p_len);
-	--p_max;
-	tiles = malloc(sizeof(tile_t)*(size_t)(1+options_lo));
-	if (!tiles) {
-		flush_log(stderr, "Could not allocate memory for tiles\n");
-		return 0;
+	if (count_flag && (estimate_probes || schedule_probes || json_flag || split_units || merge_path || server_path || store_path)) {
+		flush_log(stderr, "Option -c excludes options -e, -l, -j, -S, -M, -D and -R.\n");
+		return EXIT_FAILURE;
 	}
-	tiles_max = 1;
-	mondrian_tiles = malloc(sizeof(tile_t *)*(size_t)options_hi);
-	if (!mondrian_tiles) {
-		flush_log(stderr, "Could not allocate memory for mondrian_tiles\n");
-		free(tiles);
-		return 0;
+	if (pair_flag && (split_units || work_path || merge_path)) {
+		flush_log(stderr, "Option -B excludes options -S, -W and -M.\n");
+		return EXIT_FAILURE;
 	}
-	options = malloc(sizeof(option_t)*(size_t)(options_hi+1));
-	if (!options) {
-		flush_log(stderr, "Could not allocate memory for options\n");
-		free(mondrian_tiles);
-		free(tiles);
-		return 0;
+	if (levels_n > 1 && (split_units || work_path || merge_path)) {
+		flush_log(stderr, "Option -P excludes options -S, -W and -M.\n");
+		return EXIT_FAILURE;
 	}
-	solutions = malloc(sizeof(option_t *)*(size_t)options_hi);
-	if (!solutions) {
-		flush_log(stderr, "Could not allocate memory for solutions\n");
-		free(options);
-		free(mondrian_tiles);
-		free(tiles);
-		return 0;
+	if (workers_flag && !schedule_probes) {
+		flush_log(stderr, "Option -w expects option -l.\n");
+		return EXIT_FAILURE;
 	}
-	choices_n = options_hi*2;
-	choices = malloc(sizeof(choice_t)*(size_t)(choices_n+1));
-	if (!choices) {
-		flush_log(stderr, "Could not allocate memory for choices\n");
-		free(solutions);
-		free(options);
-		free(mondrian_tiles);
-		free(tiles);
-		return 0;
+	if ((import_path || view_path) && !store_path) {
+		flush_log(stderr, "Options -I and -V expect option -R.\n");
+		return EXIT_FAILURE;
 	}
-	choices_header = choices+choices_n;
-	set_choice(choices, 0, 0);
-	if (request == REQUEST_SQUARES) {
-		for (paint_height = order_lo; paint_height <= order_hi; ++paint_height) {
-			paint_width = paint_height;
-			if (!run_request("Square")) {
-				free_data();
-				return EXIT_FAILURE;
-			}
+	if (merge_path) {
+		if (!run_merge(argc-merge_idx, argv+merge_idx)) {
+			return EXIT_FAILURE;
 		}
+		flush_log(stdout, "Bye\n");
+		return EXIT_SUCCESS;
 	}
-	else if (request == REQUEST_RECTANGLES) {
-		for (paint_width = order_lo; paint_width <= order_hi; ++paint_width) {
-			for (paint_height = 1; paint_height <= paint_width; ++paint_height) {
-				if (!run_request("Rectangle")) {
-					free_data();
-					return EXIT_FAILURE;
-				}
+	set_budget(0UL, 0);
+	if (json_flag) {
+		setvbuf(stdout, NULL, _IOFBF, JSON_BUFFER_SIZE);
+		json_time = get_time();
+	}
+	if (store_path) {
+		if (!open_store()) {
+			return EXIT_FAILURE;
+		}
+		if (import_path || view_path) {
+			r = run_import();
+			close_store();
+			if (!r) {
+				return EXIT_FAILURE;
 			}
+			flush_log(stdout, "Bye\n");
+			return EXIT_SUCCESS;
 		}
 	}
-	else {
-		paint_height = order_lo;
-		paint_width = order_hi;
-		if (!run_request("Unique")) {
+	if (server_path) {
+		r = run_server();
+		if (r >= 0) {
 			free_data();
+		}
+		if (store_path) {
+			close_store();
+		}
+		return r > 0 ? EXIT_SUCCESS:EXIT_FAILURE;
+	}
+	if (work_path) {
+		if (!read_unit(&order_lo, &order_hi)) {
 			return EXIT_FAILURE;
 		}
+		request = 0;
+		verbose_flag = 0;
 	}
-	flush_log(stdout, "Bye\n");
-	free_data();
-	return EXIT_SUCCESS;
-}
-
-static int run_request(const char *request) {
-	int r;
-	flush_log(stdout, "%s %dx%d\n", request, paint_height, paint_width);
-	paint_area = paint_height*paint_width;
-	if (SIZE_T_MAX/(unsigned)paint_area < sizeof(int)) {
-		flush_log(stderr, "Will not be able to allocate memory for counts\n");
-		return 0;
+	else if (scanf("%d%d%d%d%d%d%d%d%d", &request, &order_lo, &order_hi, &rotate_flag, &defect_a, &defect_b, &options_lo, &options_hi, &verbose_flag) != 9 || !is_valid_request(order_lo, order_hi)) {
+		flush_log(stderr, "Expected parameters: request (%d = squares / %d = rectangles / other = unique), order_lo (>= 1), order_hi (>= order_lo), rotate_flag, defect_a (>= 0), defect_b (>= 0), options_lo (>= %d), options_hi (>= options_lo), verbose_flag.\n", REQUEST_SQUARES, REQUEST_RECTANGLES, OPTIONS_MIN);
+		if (store_path) {
+			close_store();
+		}
+		return EXIT_FAILURE;
 	}
-	counts = malloc(sizeof(int)*(size_t)paint_area);
-	if (!counts) {
-		flush_log(stderr, "Could not allocate memory for counts\n");
-		return 0;
+	if (split_units && (request == REQUEST_SQUARES || request == REQUEST_RECTANGLES || defect_a > defect_b)) {
+		flush_log(stderr, "Option -S expects a unique request and defect_a <= defect_b.\n");
+		return EXIT_FAILURE;
 	}
-	bars = malloc(sizeof(bar_t)*(size_t)(paint_height+1));
-	if (!bars) {
-		flush_log(stderr, "Could not allocate memory for bars\n");
-		free(counts);
-		return 0;
+	if (count_flag && defect_a > defect_b) {
+		flush_log(stderr, "Option -c expects defect_a <= defect_b.\n");
+		return EXIT_FAILURE;
 	}
-	bars_header = bars+paint_height;
-	insert_bar(bars, bars_header, bars_header);
-	defect_cur = defect_a;
-	if (defect_a <= defect_b) {
-		do {
-			r = 0;
-			for (options_cur = options_lo; options_cur <= options_hi && !r; ++options_cur) {
-				r = search_defect();
-			}
-			++defect_cur;
+	if (json_flag) {
+		verbose_flag = 0;
+	}
+	for (p_max = 1, p_len = 0; p_max <= INT_MAX/P_MUL; p_max *= P_MUL, ++p_len);
+	--p_max;
+	if (!alloc_data()) {
+		if (store_path) {
+			close_store();
 		}
-		while ((!r || r == NOT_ENOUGH_TILES) && defect_cur <= defect_b);
+		return EXIT_FAILURE;
+	}
+	if (split_units || work_path) {
+		paint_height = order_lo;
+		paint_width = order_hi;
+		r = split_units ? run_split():run_work();
 	}
 	else {
-		r = 0;
-		for (options_cur = options_lo; options_cur <= options_hi && (!r || r == 1) && defect_cur >= defect_b; ++options_cur) {
-			r = search_defect();
-		}
+		r = run_requests(request, order_lo, order_hi);
 	}
-	free(bars);
-	free(counts);
-	if (r < 0) {
+	free_data();
+	if (store_path) {
+		close_store();
+	}
+	if (!r) {
+		return EXIT_FAILURE;
+	}
+	if (!json_flag) {
+		flush_log(stdout, "Bye\n");
+	}
+	return EXIT_SUCCESS;
+}
+
+static int read_option(int argc, char *argv[], int *i, long value_min, long value_max, long *value) {
+	char *end;
+	++*i;
+	if (*i == argc) {
 		return 0;
 	}
-	return 1;
+	*value = strtol(argv[*i], &end, 10);
+	return !*end && end != argv[*i] && *value >= value_min && *value <= value_max;
 }
 
-static int search_defect(void) {
-	int area, width, height, i;
-	for (i = paint_area; i--; ) {
-		counts[i] = 0;
+static int read_path(int argc, char *argv[], int *i, const char **path) {
+	++*i;
+	if (*i == argc) {
+		return 0;
 	}
-	for (width = 1; width < paint_height; ++width) {
-		area = 0;
-		for (height = 1; height < width; ++height) {
-			area += width;
-			if (is_valid_area(area)) {
-				if (rotate_flag) {
-					if ((check_tile1(width, height, area) || check_tile1(height, width, area))) {
-						++counts[area-1];
-					}
-				}
-				else {
-					if (check_tile1(width, height, area)) {
-						++counts[area-1];
-					}
-					if (check_tile1(height, width, area)) {
-						++counts[area-1];
-					}
+	*path = argv[*i];
+	return 1;
+}
+
+static int run_requests(int request, int order_lo, int order_hi) {
+	int paints_max, paints_n, i;
+	const char *label;
+	paint_t *paints;
+	double *loads;
+	if (request == REQUEST_SQUARES) {
+		if (!schedule_probes) {
+			for (paint_height = order_lo; paint_height <= order_hi; ++paint_height) {
+				paint_width = paint_height;
+				if (!run_paint("Square")) {
+					return 0;
 				}
 			}
+			return 1;
 		}
-		area += width;
-		if (check_tile1(width, width, area) && is_valid_area(area)) {
-			++counts[area-1];
-		}
+		label = "Square";
+		paints_max = order_hi-order_lo+1;
 	}
-	area = 0;
-	if (paint_height < paint_width) {
-		for (height = 1; height < paint_height; ++height) {
-			area += width;
-			if (is_valid_area(area)) {
-				if (rotate_flag) {
-					if ((check_tile1(height, width, area) || check_big_tile1(paint_width, height, width, area))) {
-						++counts[area-1];
-					}
-				}
-				else {
-					if (check_tile1(height, width, area)) {
-						++counts[area-1];
-					}
-					if (check_big_tile1(paint_width, height, width, area)) {
-						++counts[area-1];
+	else if (request == REQUEST_RECTANGLES) {
+		if (!schedule_probes) {
+			for (paint_width = order_lo; paint_width <= order_hi; ++paint_width) {
+				for (paint_height = 1; paint_height <= paint_width; ++paint_height) {
+					if (!run_paint("Rectangle")) {
+						return 0;
 					}
 				}
 			}
+			return 1;
 		}
-		area += width;
-		if (check_big_tile1(paint_width, width, width, area) && is_valid_area(area)) {
-			++counts[area-1];
-		}
-		for (++width; width < paint_width; ++width) {
-			area = 0;
-			for (height = 1; height < paint_height; ++height) {
-				area += width;
-				if (check_tile1(height, width, area) && is_valid_area(area)) {
-					++counts[area-1];
-				}
-			}
-			area += width;
-			if (check_big_tile1(paint_width, width, height, area) && is_valid_area(area)) {
-				++counts[area-1];
+		label = "Rectangle";
+		for (paints_max = 0, i = order_lo; i <= order_hi; ++i) {
+			if (paints_max > INT_MAX-i) {
+				flush_log(stderr, "Too many rectangles to schedule\n");
+				return 0;
 			}
+			paints_max += i;
 		}
-		area = 0;
-		for (height = 1; height < paint_height; ++height) {
-			area += width;
-			if (check_big_tile1(paint_height, height, width, area) && is_valid_area(area)) {
-				++counts[area-1];
-			}
+	}
+	else {
+		paint_height = order_lo;
+		paint_width = order_hi;
+		return run_paint("Unique");
+	}
+	paints = malloc(sizeof(paint_t)*(size_t)paints_max);
+	if (!paints) {
+		flush_log(stderr, "Could not allocate memory for paints\n");
+		return 0;
+	}
+	loads = calloc((size_t)workers_n, sizeof(double));
+	if (!loads) {
+		flush_log(stderr, "Could not allocate memory for loads\n");
+		free(paints);
+		return 0;
+	}
+	if (request == REQUEST_SQUARES) {
+		for (i = 0; i < paints_max; ++i) {
+			set_paint(paints+i, order_lo+i, order_lo+i);
 		}
 	}
 	else {
-		for (height = 1; height < paint_height; ++height) {
-			area += width;
-			if (check_big_tile1(paint_width, height, width, area) && is_valid_area(area)) {
-				++counts[area-1];
-				if (!rotate_flag) {
-					++counts[area-1];
-				}
+		for (paints_n = 0, paint_width = order_lo; paint_width <= order_hi; ++paint_width) {
+			for (paint_height = 1; paint_height <= paint_width; ++paint_height, ++paints_n) {
+				set_paint(paints+paints_n, paint_height, paint_width);
 			}
 		}
 	}
-	tiles_n = 0;
-	for (i = paint_area; i--; ) {
-		if (counts[i]) {
-			check_count(i);
+	probes_n = schedule_probes;
+	for (i = 0; i < paints_max; ++i) {
+		int r;
+		paint_height = paints[i].height;
+		paint_width = paints[i].width;
+		if (!alloc_paint()) {
+			probes_n = 0;
+			free(loads);
+			free(paints);
+			return 0;
+		}
+		r = estimate_paint(paints+i);
+		free(width_fits);
+		free(ledges);
+		free(bars);
+		free(counts);
+		if (r < 0) {
+			probes_n = 0;
+			free(loads);
+			free(paints);
+			return 0;
 		}
 	}
-	flush_log(stdout, "Current %d Tiles %d\n", defect_cur, tiles_n);
-	if (tiles_n >= options_cur) {
-		if (tiles_n > tiles_max) {
-			tile_t *tiles_tmp = realloc(tiles, sizeof(tile_t)*(size_t)tiles_n);
-			if (!tiles_tmp) {
+	probes_n = 0;
+	qsort(paints, (size_t)paints_max, sizeof(paint_t), compare_paints);
+	for (i = 0; i < paints_max; ++i) {
+		int worker = 0, j;
+		for (j = 1; j < workers_n; ++j) {
+			if (loads[j] < loads[worker]) {
+				worker = j;
+			}
+		}
+		loads[worker] += paints[i].nodes;
+		if (worker == worker_idx) {
+			paint_height = paints[i].height;
+			paint_width = paints[i].width;
+			if (!run_paint(label)) {
+				free(loads);
+				free(paints);
+				return 0;
+			}
+		}
+	}
+	free(loads);
+	free(paints);
+	return 1;
+}
+
+static int run_paint(const char *request) {
+	int rotate_input = rotate_flag, r, i;
+	if (!pair_flag) {
+		return run_request(request);
+	}
+	pair_lower = -1;
+	pair_upper = -1;
+	pair_defect = -1;
+	rotate_flag = defect_a > defect_b;
+	for (i = 0, r = 1; i < 2 && r; ++i, rotate_flag = !rotate_flag) {
+		if (!json_flag) {
+			flush_log(stdout, "Rotate %d\n", rotate_flag);
+		}
+		r = run_request(request);
+	}
+	pair_lower = -1;
+	pair_upper = -1;
+	pair_defect = -1;
+	rotate_flag = rotate_input;
+	return r;
+}
+
+static int run_request(const char *request) {
+	int r, pair_bound_flag = 0, timeout_status = 0, timeout_current = 0, timeout_options = 0, store_lower = -1, defect_start = 0, defect_exhausted = -1, defect_limit = defect_b;
+	unsigned long nodes_start;
+	double time_start;
+	const record_t *store_tiling = NULL;
+	paint_t paint;
+	if (!json_flag) {
+		flush_log(stdout, "%s %dx%d\n", request, paint_height, paint_width);
+	}
+	if (store_path && !estimate_probes) {
+		if (!refresh_store()) {
+			return 0;
+		}
+		lookup_store(&store_lower, &store_tiling);
+		if (store_tiling && store_lower >= store_tiling->defect_lo-1 && is_in_defects(store_tiling->defect_lo)) {
+			print_known(request, store_tiling);
+			if (pair_flag) {
+				pair_lower = store_lower;
+				pair_upper = store_tiling->defect_lo;
+				return set_pair_places(store_tiling);
+			}
+			return 1;
+		}
+	}
+	if (!alloc_paint()) {
+		return 0;
+	}
+	set_stats();
+	TELEMETRY(set_telemetry());
+	places_defect = -1;
+	if (count_flag) {
+		clear_tilings();
+	}
+	nodes_start = nodes_n;
+	time_start = get_time();
+	if (estimate_probes) {
+		set_paint(&paint, paint_height, paint_width);
+		probes_n = estimate_probes;
+		r = estimate_paint(&paint);
+		probes_n = 0;
+		if (!r && !json_flag) {
+			flush_log(stdout, "Estimate nodes %.3e seconds %.3e\n", paint.nodes, paint.seconds);
+		}
+	}
+	else {
+		set_budget(budget_nodes, budget_seconds);
+		defect_cur = defect_a;
+		if (defect_a <= defect_b) {
+			if (store_lower >= defect_cur) {
+				defect_cur = store_lower+1;
+				if (!json_flag) {
+					flush_log(stdout, "Store no solution with defect <= %d\n", store_lower);
+				}
+			}
+			defect_start = defect_cur;
+			if (pair_lower >= defect_cur) {
+				defect_cur = pair_lower+1;
+				if (!json_flag) {
+					flush_log(stdout, "Pair no solution with defect <= %d\n", pair_lower);
+				}
+			}
+			defect_exhausted = defect_cur-1;
+			r = 0;
+			if (levels_n > 1) {
+				r = search_levels(&defect_exhausted);
+			}
+			while ((!r || r == NOT_ENOUGH_TILES) && defect_cur <= defect_b && !timeout_flag && !tilings_n) {
+				r = 0;
+				for (options_cur = options_lo; options_cur <= options_hi && !r && !timeout_flag; ++options_cur) {
+					r = search_defect();
+				}
+				if ((!r || r == NOT_ENOUGH_TILES) && !timeout_flag && !tilings_n && defect_exhausted == defect_cur-1 && options_lo == OPTIONS_MIN && (r || options_cur > tiles_n)) {
+					defect_exhausted = defect_cur;
+				}
+				++defect_cur;
+			}
+			if (timeout_flag) {
+				timeout_status = 1;
+				timeout_current = defect_cur-1;
+				timeout_options = options_cur-1;
+				if (!json_flag) {
+					flush_log(stdout, "Timeout current %d options %d\n", timeout_current, timeout_options);
+					if (defect_cur-1 > defect_a) {
+						flush_log(stdout, "No solution found with defect %d to %d\n", defect_a, defect_cur-2);
+					}
+				}
+			}
+			if (tilings_n) {
+				flush_log(stdout, "Tilings %lu defect %d\n", tilings_n, defect_cur-1);
+			}
+			if (pair_flag) {
+				pair_lower = defect_exhausted;
+			}
+		}
+		else {
+			r = 0;
+			if (store_path && !bound_store(&store_lower, &store_tiling)) {
+				r = -1;
+			}
+			if (pair_upper >= 0 && pair_upper <= defect_cur) {
+				defect_cur = pair_upper-1;
+				pair_bound_flag = 1;
+				if (!json_flag) {
+					flush_log(stdout, "Pair upper bound %d\n", pair_upper);
+				}
+			}
+			for (options_cur = options_lo; options_cur <= options_hi && (!r || r == 1) && defect_cur >= defect_b && !timeout_flag; ++options_cur) {
+				r = search_defect();
+				if (store_path && (!r || r == 1) && !bound_store(&store_lower, &store_tiling)) {
+					r = -1;
+				}
+			}
+			defect_b = defect_limit;
+			if (pair_bound_flag && places_defect < 0 && pair_defect == pair_upper) {
+				places_defect = pair_defect;
+				if (!json_flag) {
+					print_places();
+				}
+			}
+			if (pair_flag && defect_cur < defect_a) {
+				pair_upper = defect_cur+1;
+				if (places_defect >= 0) {
+					pair_defect = places_defect;
+				}
+			}
+			if (timeout_flag) {
+				timeout_status = 1;
+				timeout_current = defect_cur;
+				timeout_options = options_cur-1;
+				if (!json_flag) {
+					flush_log(stdout, "Timeout current %d options %d\n", timeout_current, timeout_options);
+					if (defect_cur < defect_a) {
+						flush_log(stdout, "Upper bound %d\n", defect_cur+1);
+					}
+				}
+			}
+		}
+		set_budget(0UL, 0);
+	}
+	free(width_fits);
+	free(ledges);
+	free(bars);
+	free(counts);
+	if (r < 0) {
+		return 0;
+	}
+	if (store_path && !estimate_probes) {
+		if (defect_exhausted >= defect_start && !append_record(paint_height, paint_width, rotate_flag, RECORD_EXHAUSTED, defect_start, defect_exhausted, 0, NULL)) {
+			return 0;
+		}
+		if (places_defect >= 0 && (!store_tiling || places_defect < store_tiling->defect_lo) && !append_record(paint_height, paint_width, rotate_flag, RECORD_TILING, places_defect, places_defect, places_n, places)) {
+			return 0;
+		}
+	}
+	if (json_flag) {
+		print_json(request, estimate_probes ? &paint:NULL, timeout_status, timeout_current, timeout_options, nodes_n-nodes_start, get_time()-time_start);
+		return 1;
+	}
+	if (stats_flag) {
+		print_stats(nodes_n-nodes_start, get_time()-time_start);
+	}
+	TELEMETRY(print_telemetry());
+	return 1;
+}
+
+static int search_levels(int *defect_exhausted) {
+	int defect_first = defect_cur, defect_next = defect_cur, r = 0, i;
+	level_t *levels = malloc(sizeof(level_t)*(size_t)levels_n);
+	if (!levels) {
+		flush_log(stderr, "Could not allocate memory for levels\n");
+		return -1;
+	}
+	for (i = levels_n; i--; ) {
+		levels[i].pid = 0;
+	}
+	while ((!r || r == NOT_ENOUGH_TILES) && defect_cur <= defect_b && !timeout_flag && !tilings_n) {
+		level_t *level = levels+(defect_cur-defect_first)%levels_n;
+		for (; r >= 0 && defect_next <= defect_b && defect_next-defect_cur < levels_n; ++defect_next) {
+			if (!start_level(levels+(defect_next-defect_first)%levels_n, defect_next)) {
+				r = -1;
+			}
+		}
+		if (r >= 0) {
+			r = wait_level(level);
+		}
+		if (r >= 0) {
+			r = read_level(level, defect_exhausted);
+		}
+	}
+	stop_levels(levels);
+	free(levels);
+	return r;
+}
+
+static int start_level(level_t *level, int defect) {
+	level->output = tmpfile();
+	if (!level->output) {
+		flush_log(stderr, "Could not create level output\n");
+		return 0;
+	}
+	level->outcomes = tmpfile();
+	if (!level->outcomes) {
+		flush_log(stderr, "Could not create level outcome\n");
+		fclose(level->output);
+		return 0;
+	}
+	fflush(stdout);
+	level->pid = fork();
+	if (level->pid < 0) {
+		flush_log(stderr, "Could not start level\n");
+		fclose(level->outcomes);
+		fclose(level->output);
+		level->pid = 0;
+		return 0;
+	}
+	if (!level->pid) {
+		run_level(level, defect);
+	}
+	return 1;
+}
+
+static void run_level(level_t *level, int defect) {
+	int r = 0;
+	unsigned long nodes_start = nodes_n;
+	if (dup2(fileno(level->output), STDOUT_FILENO) < 0) {
+		flush_log(stderr, "Could not redirect level output\n");
+		_exit(EXIT_FAILURE);
+	}
+	set_stats();
+	set_nodes_limit(budget_nodes);
+	defect_cur = defect;
+	for (options_cur = options_lo; options_cur <= options_hi && !r && !timeout_flag; ++options_cur) {
+		r = search_defect();
+	}
+	level->outcome.r = r;
+	level->outcome.options = options_cur;
+	level->outcome.timeout_flag = timeout_flag;
+	level->outcome.exhausted_flag = (!r || r == NOT_ENOUGH_TILES) && !timeout_flag && !tilings_n && options_lo == OPTIONS_MIN && (r || options_cur > tiles_n);
+	level->outcome.places_defect = places_defect;
+	level->outcome.places_n = places_n;
+	level->outcome.tilings_n = tilings_n;
+	level->outcome.nodes_n = nodes_n-nodes_start;
+	level->outcome.stats = stats;
+	fflush(stdout);
+	if (fwrite(&level->outcome, sizeof(outcome_t), (size_t)1, level->outcomes) != (size_t)1 || (places_defect >= 0 && fwrite(places, sizeof(place_t), (size_t)places_n, level->outcomes) != (size_t)places_n) || fflush(level->outcomes)) {
+		_exit(EXIT_FAILURE);
+	}
+	_exit(EXIT_SUCCESS);
+}
+
+static int wait_level(level_t *level) {
+	int status;
+	pid_t pid = waitpid(level->pid, &status, 0);
+	while (pid < 0 && errno == EINTR) {
+		pid = waitpid(level->pid, &status, 0);
+	}
+	if (pid < 0) {
+		flush_log(stderr, "Could not wait for level\n");
+		return -1;
+	}
+	level->pid = -1;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+		flush_log(stderr, "Could not complete level\n");
+		return -1;
+	}
+	rewind(level->outcomes);
+	if (fread(&level->outcome, sizeof(outcome_t), (size_t)1, level->outcomes) != (size_t)1) {
+		flush_log(stderr, "Could not read level outcome\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int read_level(level_t *level, int *defect_exhausted) {
+	size_t n;
+	char buffer[LEVEL_BUFFER_SIZE];
+	rewind(level->output);
+	for (n = fread(buffer, (size_t)1, LEVEL_BUFFER_SIZE, level->output); n; n = fread(buffer, (size_t)1, LEVEL_BUFFER_SIZE, level->output)) {
+		fwrite(buffer, (size_t)1, n, stdout);
+	}
+	fflush(stdout);
+	if (level->outcome.places_defect >= 0) {
+		if (fread(places, sizeof(place_t), (size_t)level->outcome.places_n, level->outcomes) != (size_t)level->outcome.places_n) {
+			flush_log(stderr, "Could not read level places\n");
+			return -1;
+		}
+		places_defect = level->outcome.places_defect;
+		places_n = level->outcome.places_n;
+	}
+	options_cur = level->outcome.options;
+	timeout_flag = level->outcome.timeout_flag;
+	tilings_n += level->outcome.tilings_n;
+	nodes_n += level->outcome.nodes_n;
+	add_stats(&level->outcome.stats);
+	if (level->outcome.exhausted_flag && *defect_exhausted == defect_cur-1) {
+		*defect_exhausted = defect_cur;
+	}
+	fclose(level->outcomes);
+	fclose(level->output);
+	level->pid = 0;
+	++defect_cur;
+	return level->outcome.r;
+}
+
+static void stop_levels(level_t *levels) {
+	int i;
+	for (i = levels_n; i--; ) {
+		if (levels[i].pid > 0) {
+			kill(levels[i].pid, SIGKILL);
+			while (waitpid(levels[i].pid, NULL, 0) < 0 && errno == EINTR);
+		}
+		if (levels[i].pid) {
+			fclose(levels[i].outcomes);
+			fclose(levels[i].output);
+			levels[i].pid = 0;
+		}
+	}
+}
+
+static int run_split(void) {
+	int r, prefixes_start, unit, i;
+	char *name;
+	double nodes_sum, nodes_unit, nodes;
+	flush_log(stdout, "Split %dx%d\n", paint_height, paint_width);
+	if (!alloc_paint()) {
+		return 0;
+	}
+	set_stats();
+	srand(PROBES_SEED);
+	probes_n = split_probes;
+	prefixes_n = 0;
+	r = 0;
+	for (defect_cur = defect_a; defect_cur <= defect_b && r >= 0; ++defect_cur) {
+		prefixes_start = prefixes_n;
+		for (options_cur = options_lo; options_cur <= options_hi && r >= 0; ++options_cur) {
+			prefix_depth = options_cur < SPLIT_DEPTH ? options_cur:SPLIT_DEPTH;
+			r = search_defect();
+		}
+		if (r >= 0 && prefixes_n == prefixes_start) {
+			if (grow_prefixes()) {
+				set_prefix(prefixes+prefixes_n, defect_cur, options_lo, 0.0);
+				++prefixes_n;
+			}
+			else {
+				r = -1;
+			}
+		}
+	}
+	probes_n = 0;
+	prefix_depth = 0;
+	free(width_fits);
+	free(ledges);
+	free(bars);
+	free(counts);
+	if (r < 0) {
+		free(prefixes);
+		return 0;
+	}
+	for (nodes_sum = 0.0, i = 0; i < prefixes_n; ++i) {
+		nodes_sum += prefixes[i].nodes;
+	}
+	nodes_unit = nodes_sum/split_units;
+	for (nodes = 0.0, unit = 0, i = 0; i < prefixes_n; ++i) {
+		prefixes[i].unit = unit;
+		nodes += prefixes[i].nodes;
+		if (nodes >= nodes_unit && unit+1 < split_units) {
+			nodes_unit += nodes_sum/split_units;
+			++unit;
+		}
+	}
+	flush_log(stdout, "Split prefixes %d nodes %.3e\n", prefixes_n, nodes_sum);
+	name = malloc(strlen(split_path)+UNIT_NAME_SIZE);
+	if (!name) {
+		flush_log(stderr, "Could not allocate memory for name\n");
+		free(prefixes);
+		return 0;
+	}
+	for (unit = 0; unit < split_units; ++unit) {
+		FILE *fd;
+		sprintf(name, "%s%d.unit", split_path, unit);
+		fd = fopen(name, "w");
+		if (!fd) {
+			flush_log(stderr, "Could not open unit file %s\n", name);
+			free(name);
+			free(prefixes);
+			return 0;
+		}
+		fprintf(fd, "Unit %d of %d paint %d %d rotate %d segments %d\n", unit, split_units, paint_height, paint_width, rotate_flag, print_segments(unit, NULL, &nodes));
+		print_segments(unit, fd, &nodes);
+		if (fclose(fd)) {
+			flush_log(stderr, "Could not write unit file %s\n", name);
+			free(name);
+			free(prefixes);
+			return 0;
+		}
+		flush_log(stdout, "Unit %d nodes %.3e file %s\n", unit, nodes, name);
+	}
+	free(name);
+	free(prefixes);
+	return 1;
+}
+
+static int print_segments(int unit, FILE *fd, double *nodes) {
+	int segments, prefix, prefix_start, i;
+	*nodes = 0.0;
+	for (segments = 0, prefix = 0, prefix_start = 0, i = 0; i < prefixes_n; ++i, ++prefix) {
+		if (i && (prefixes[i].defect != prefixes[i-1].defect || prefixes[i].options != prefixes[i-1].options)) {
+			prefix = 0;
+		}
+		if (prefixes[i].unit == unit) {
+			if (!prefix || prefixes[i-1].unit != unit) {
+				prefix_start = prefix;
+			}
+			*nodes += prefixes[i].nodes;
+			if (i+1 == prefixes_n || prefixes[i+1].unit != unit || prefixes[i+1].defect != prefixes[i].defect || prefixes[i+1].options != prefixes[i].options) {
+				if (fd) {
+					fprintf(fd, "Segment defect %d options %d prefixes %d %d\n", prefixes[i].defect, prefixes[i].options, prefix_start, prefix+1);
+				}
+				++segments;
+			}
+		}
+	}
+	return segments;
+}
+
+static int read_unit(int *order_lo, int *order_hi) {
+	int segment_defect, segment_options, segment_lo, segment_hi, i;
+	FILE *fd = fopen(work_path, "r");
+	if (!fd) {
+		flush_log(stderr, "Could not open unit file %s\n", work_path);
+		return 0;
+	}
+	if (fscanf(fd, " Unit %d of %d paint %d %d rotate %d segments %d", &unit_idx, &units_n, order_lo, order_hi, &rotate_flag, &segments_n) != 6 || units_n < 1 || unit_idx < 0 || unit_idx >= units_n || *order_lo < 1 || *order_lo > *order_hi || (unsigned)*order_lo > SIZE_T_MAX/(unsigned)*order_hi || segments_n < 0) {
+		flush_log(stderr, "Invalid unit header in file %s\n", work_path);
+		fclose(fd);
+		return 0;
+	}
+	defect_a = INT_MAX;
+	defect_b = 0;
+	options_lo = INT_MAX;
+	options_hi = OPTIONS_MIN;
+	for (i = 0; i < segments_n; ++i) {
+		if (fscanf(fd, " Segment defect %d options %d prefixes %d %d", &segment_defect, &segment_options, &segment_lo, &segment_hi) != 4 || segment_defect < 0 || segment_options < OPTIONS_MIN || segment_lo < 0 || segment_lo > segment_hi) {
+			flush_log(stderr, "Invalid unit segment in file %s\n", work_path);
+			fclose(fd);
+			return 0;
+		}
+		if (segment_defect < defect_a) {
+			defect_a = segment_defect;
+		}
+		if (segment_defect > defect_b) {
+			defect_b = segment_defect;
+		}
+		if (segment_options < options_lo) {
+			options_lo = segment_options;
+		}
+		if (segment_options > options_hi) {
+			options_hi = segment_options;
+		}
+	}
+	fclose(fd);
+	if (!segments_n) {
+		defect_a = 0;
+		options_lo = OPTIONS_MIN;
+	}
+	return 1;
+}
+
+static int run_work(void) {
+	int r, i;
+	unsigned long nodes_start, tilings_start;
+	double time_work = get_time(), time_start;
+	FILE *fd = fopen(work_path, "r");
+	if (!fd) {
+		flush_log(stderr, "Could not open unit file %s\n", work_path);
+		return 0;
+	}
+	if (fscanf(fd, " Unit %*d of %*d paint %*d %*d rotate %*d segments %*d") == EOF || !alloc_paint()) {
+		fclose(fd);
+		return 0;
+	}
+	flush_log(stdout, "Unit %d of %d paint %d %d rotate %d segments %d\n", unit_idx, units_n, paint_height, paint_width, rotate_flag, segments_n);
+	set_stats();
+	if (count_flag) {
+		clear_tilings();
+	}
+	set_budget(budget_nodes, budget_seconds);
+	for (r = 0, i = 0; i < segments_n && r >= 0; ++i) {
+		const char *status;
+		if (fscanf(fd, " Segment defect %d options %d prefixes %d %d", &defect_cur, &options_cur, &prefix_lo, &prefix_hi) != 4) {
+			flush_log(stderr, "Invalid unit segment in file %s\n", work_path);
+			r = -1;
+			break;
+		}
+		prefix_depth = options_cur < SPLIT_DEPTH ? options_cur:SPLIT_DEPTH;
+		nodes_start = nodes_n;
+		tilings_start = tilings_n;
+		time_start = get_time();
+		if (r == 1 || (tilings_n && defect_cur > places_defect)) {
+			status = "skipped";
+		}
+		else if (timeout_flag) {
+			status = "aborted";
+		}
+		else {
+			prefixes_n = 0;
+			r = search_defect();
+			if (r == 1 || tilings_n > tilings_start) {
+				status = "solved";
+			}
+			else {
+				status = timeout_flag ? "aborted":"exhausted";
+				if (r > 0) {
+					r = 0;
+				}
+			}
+		}
+		if (r >= 0) {
+			if (count_flag) {
+				flush_log(stdout, "Segment defect %d options %d prefixes %d %d status %s nodes %lu seconds %.6f tilings %lu\n", defect_cur, options_cur, prefix_lo, prefix_hi, status, nodes_n-nodes_start, get_time()-time_start, tilings_n-tilings_start);
+			}
+			else {
+				flush_log(stdout, "Segment defect %d options %d prefixes %d %d status %s nodes %lu seconds %.6f\n", defect_cur, options_cur, prefix_lo, prefix_hi, status, nodes_n-nodes_start, get_time()-time_start);
+			}
+		}
+	}
+	set_budget(0UL, 0);
+	prefix_depth = 0;
+	fclose(fd);
+	free(width_fits);
+	free(ledges);
+	free(bars);
+	free(counts);
+	if (r < 0) {
+		return 0;
+	}
+	if (stats_flag) {
+		print_stats(nodes_n, get_time()-time_work);
+	}
+	return 1;
+}
+
+static int run_merge(int files_n, char *files[]) {
+	int units_total = 0, height = 0, width = 0, rotate = 0, defect_lo = INT_MAX, defect_hi = -1, defect_best = INT_MAX, defect_open = INT_MAX, defect_stop, exhausted_n = 0, solved_n = 0, aborted_n = 0, skipped_n = 0, complete_flag = 1, tilings_defect = INT_MAX, defects_max = 0, *units_flags = NULL, *defects_flags = NULL, i;
+	unsigned long tilings_sum = 0UL;
+	const char *file_best = NULL;
+	for (i = 0; i < files_n; ++i) {
+		int unit, units, unit_height, unit_width, unit_rotate, unit_segments, segments, defect;
+		unsigned long tilings;
+		char line[MERGE_LINE_SIZE], status[STATUS_SIZE];
+		FILE *fd = fopen(files[i], "r");
+		if (!fd) {
+			flush_log(stderr, "Could not open result file %s\n", files[i]);
+			free(defects_flags);
+			free(units_flags);
+			return 0;
+		}
+		unit = -1;
+		unit_segments = 0;
+		segments = 0;
+		while (fgets(line, MERGE_LINE_SIZE, fd)) {
+			if (sscanf(line, "Unit %d of %d paint %d %d rotate %d segments %d", &unit, &units, &unit_height, &unit_width, &unit_rotate, &unit_segments) == 6) {
+				if (!units_flags) {
+					if (units < 1) {
+						break;
+					}
+					units_flags = calloc((size_t)units, sizeof(int));
+					if (!units_flags) {
+						flush_log(stderr, "Could not allocate memory for units_flags\n");
+						fclose(fd);
+						free(defects_flags);
+						return 0;
+					}
+					units_total = units;
+					height = unit_height;
+					width = unit_width;
+					rotate = unit_rotate;
+				}
+				if (units != units_total || unit_height != height || unit_width != width || unit_rotate != rotate || unit < 0 || unit >= units_total || units_flags[unit]) {
+					unit = -1;
+					break;
+				}
+				units_flags[unit] = 1;
+			}
+			else if (unit >= 0 && sscanf(line, "Segment defect %d options %*d prefixes %*d %*d status %15s", &defect, status) == 2 && defect >= 0 && defect < INT_MAX) {
+				++segments;
+				if (defect < defect_lo) {
+					defect_lo = defect;
+				}
+				if (defect > defect_hi) {
+					defect_hi = defect;
+				}
+				if (!strcmp(status, "solved")) {
+					++solved_n;
+					if (defect < defect_best) {
+						defect_best = defect;
+						file_best = files[i];
+					}
+					if (sscanf(line, "Segment defect %*d options %*d prefixes %*d %*d status %*s nodes %*u seconds %*f tilings %lu", &tilings) == 1) {
+						if (defect < tilings_defect) {
+							tilings_defect = defect;
+							tilings_sum = 0UL;
+						}
+						if (defect == tilings_defect) {
+							tilings_sum += tilings;
+						}
+					}
+				}
+				else if (!strcmp(status, "exhausted")) {
+					++exhausted_n;
+					if (defect >= defects_max) {
+						int defects_max_tmp = defect < INT_MAX/2 ? defect*2+1:defect+1, *defects_flags_tmp = realloc(defects_flags, sizeof(int)*(size_t)defects_max_tmp);
+						if (!defects_flags_tmp) {
+							flush_log(stderr, "Could not reallocate memory for defects_flags\n");
+							fclose(fd);
+							free(defects_flags);
+							free(units_flags);
+							return 0;
+						}
+						defects_flags = defects_flags_tmp;
+						while (defects_max < defects_max_tmp) {
+							defects_flags[defects_max++] = 0;
+						}
+					}
+					defects_flags[defect] = 1;
+				}
+				else {
+					if (!strcmp(status, "aborted")) {
+						++aborted_n;
+					}
+					else {
+						++skipped_n;
+					}
+					if (defect < defect_open) {
+						defect_open = defect;
+					}
+				}
+			}
+		}
+		fclose(fd);
+		if (unit < 0) {
+			flush_log(stderr, "Invalid or duplicate unit in result file %s\n", files[i]);
+			free(defects_flags);
+			free(units_flags);
+			return 0;
+		}
+		if (segments < unit_segments) {
+			complete_flag = 0;
+		}
+	}
+	for (i = 0; i < units_total && units_flags[i]; ++i);
+	if (i < units_total) {
+		complete_flag = 0;
+	}
+	defect_stop = file_best ? defect_best:defect_hi+1;
+	for (i = defect_lo; i < defect_stop && i < defects_max && defects_flags[i]; ++i);
+	if (i < defect_stop) {
+		complete_flag = 0;
+	}
+	flush_log(stdout, "Merge paint %dx%d rotate %d units %d of %d\n", height, width, rotate, files_n, units_total);
+	flush_log(stdout, "Merge segments exhausted %d solved %d aborted %d skipped %d\n", exhausted_n, solved_n, aborted_n, skipped_n);
+	if (file_best) {
+		if (complete_flag && defect_open >= defect_best) {
+			flush_log(stdout, "Defect %d file %s\n", defect_best, file_best);
+		}
+		else {
+			flush_log(stdout, "Upper bound %d file %s\n", defect_best, file_best);
+		}
+		if (tilings_defect == defect_best) {
+			if (complete_flag && defect_open > defect_best) {
+				flush_log(stdout, "Tilings %lu\n", tilings_sum);
+			}
+			else {
+				flush_log(stdout, "Tilings at least %lu\n", tilings_sum);
+			}
+		}
+	}
+	else {
+		if (complete_flag && defect_open == INT_MAX) {
+			if (defect_hi >= 0) {
+				flush_log(stdout, "No solution found with defect %d to %d\n", defect_lo, defect_hi);
+			}
+			else {
+				flush_log(stdout, "No solution found\n");
+			}
+		}
+		else {
+			flush_log(stdout, "Incomplete\n");
+		}
+	}
+	free(defects_flags);
+	free(units_flags);
+	return 1;
+}
+
+static int is_valid_request(int order_lo, int order_hi) {
+	return order_lo >= 1 && order_lo <= order_hi && (unsigned)order_lo <= SIZE_T_MAX/(unsigned)order_hi && defect_a >= 0 && defect_b >= 0 && options_lo >= OPTIONS_MIN && options_lo <= options_hi;
+}
+
+static int run_server(void) {
+	int listen_fd, i;
+	pid_t *pids;
+	struct sockaddr_un address;
+	struct sigaction action;
+	if (!strcmp(server_path, "-")) {
+		return serve_requests();
+	}
+	if (strlen(server_path) >= sizeof(address.sun_path)) {
+		flush_log(stderr, "Socket path %s is too long\n", server_path);
+		return 0;
+	}
+	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0) {
+		flush_log(stderr, "Could not create socket\n");
+		return 0;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, server_path);
+	unlink(server_path);
+	if (bind(listen_fd, (struct sockaddr *)&address, (socklen_t)sizeof(address)) || listen(listen_fd, SERVER_BACKLOG)) {
+		flush_log(stderr, "Could not listen on socket %s\n", server_path);
+		close(listen_fd);
+		return 0;
+	}
+	pids = malloc(sizeof(pid_t)*(size_t)workers_n);
+	if (!pids) {
+		flush_log(stderr, "Could not allocate memory for pids\n");
+		close(listen_fd);
+		unlink(server_path);
+		return 0;
+	}
+	action.sa_handler = stop_server;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+	flush_log(stdout, "Server %s workers %d\n", server_path, workers_n);
+	for (i = 0; i < workers_n; ++i) {
+		pids[i] = start_worker(listen_fd);
+	}
+	while (!server_stop_flag) {
+		pid_t pid = wait(NULL);
+		if (pid > 0) {
+			for (i = 0; i < workers_n && pids[i] != pid; ++i);
+			if (i < workers_n && !server_stop_flag) {
+				pids[i] = start_worker(listen_fd);
+			}
+		}
+		else if (errno != EINTR) {
+			break;
+		}
+	}
+	for (i = 0; i < workers_n; ++i) {
+		if (pids[i] > 0) {
+			kill(pids[i], SIGTERM);
+		}
+	}
+	while (wait(NULL) > 0 || errno == EINTR);
+	close(listen_fd);
+	unlink(server_path);
+	free(pids);
+	flush_log(stdout, "Bye\n");
+	return 1;
+}
+
+static pid_t start_worker(int listen_fd) {
+	struct sigaction action;
+	pid_t pid = fork();
+	if (pid) {
+		if (pid < 0) {
+			flush_log(stderr, "Could not start worker\n");
+		}
+		return pid;
+	}
+	action.sa_handler = SIG_DFL;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+	while (1) {
+		int connection_fd = accept(listen_fd, NULL, NULL), r;
+		if (connection_fd < 0) {
+			if (server_stop_flag) {
+				exit(EXIT_SUCCESS);
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			flush_log(stderr, "Could not accept connection\n");
+			exit(EXIT_FAILURE);
+		}
+		if (dup2(connection_fd, STDIN_FILENO) < 0 || dup2(connection_fd, STDOUT_FILENO) < 0) {
+			flush_log(stderr, "Could not redirect connection\n");
+			exit(EXIT_FAILURE);
+		}
+		if (connection_fd > STDOUT_FILENO) {
+			close(connection_fd);
+		}
+		clearerr(stdin);
+		r = serve_requests();
+		fflush(stdout);
+		close(STDIN_FILENO);
+		close(STDOUT_FILENO);
+		if (r < 0) {
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+static int serve_requests(void) {
+	int request, order_lo, order_hi;
+	char line[REQUEST_LINE_SIZE];
+	while (fgets(line, REQUEST_LINE_SIZE, stdin)) {
+		int n = sscanf(line, "%d%d%d%d%d%d%d%d%d", &request, &order_lo, &order_hi, &rotate_flag, &defect_a, &defect_b, &options_lo, &options_hi, &verbose_flag);
+		if (n == EOF) {
+			continue;
+		}
+		verbose_flag = 0;
+		if (n != 9 || !is_valid_request(order_lo, order_hi)) {
+			printf("{\"end\":true,\"status\":\"error\",\"message\":\"invalid request\"}\n");
+		}
+		else {
+			if (options_hi > options_max) {
+				if (options_max) {
+					free_data();
+					options_max = 0;
+				}
+				if (!alloc_data()) {
+					printf("{\"end\":true,\"status\":\"error\",\"message\":\"out of memory\"}\n");
+					fflush(stdout);
+					return -1;
+				}
+			}
+			printf("{\"end\":true,\"status\":\"%s\"}\n", run_requests(request, order_lo, order_hi) ? "ok":"error");
+		}
+		fflush(stdout);
+		json_time = get_time();
+	}
+	return 1;
+}
+
+static void stop_server(int signal_number) {
+	server_stop_flag = signal_number;
+}
+
+static int open_store(void) {
+	int header[STORE_HEADER_SIZE];
+	struct stat status;
+	store_fd = open(store_path, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (store_fd < 0) {
+		flush_log(stderr, "Could not open store %s\n", store_path);
+		return 0;
+	}
+	if (fstat(store_fd, &status)) {
+		flush_log(stderr, "Could not get status of store %s\n", store_path);
+		close(store_fd);
+		return 0;
+	}
+	if (!status.st_size) {
+		header[0] = STORE_MAGIC;
+		header[1] = STORE_VERSION;
+		if (write(store_fd, header, sizeof(header)) != (ssize_t)sizeof(header)) {
+			flush_log(stderr, "Could not write header of store %s\n", store_path);
+			close(store_fd);
+			return 0;
+		}
+		return 1;
+	}
+	store_size = (size_t)status.st_size;
+	store_words = mmap(NULL, store_size, PROT_READ, MAP_SHARED, store_fd, (off_t)0);
+	if (store_words == MAP_FAILED) {
+		flush_log(stderr, "Could not map store %s\n", store_path);
+		store_words = NULL;
+		close(store_fd);
+		return 0;
+	}
+	if (store_size < sizeof(header) || store_words[0] != STORE_MAGIC || store_words[1] != STORE_VERSION) {
+		flush_log(stderr, "Invalid store %s\n", store_path);
+		close_store();
+		return 0;
+	}
+	if (!index_store()) {
+		close_store();
+		return 0;
+	}
+	return 1;
+}
+
+static int index_store(void) {
+	free(records);
+	records = NULL;
+	records_n = scan_store(NULL);
+	if (records_n) {
+		records = malloc(sizeof(record_t)*(size_t)records_n);
+		if (!records) {
+			flush_log(stderr, "Could not allocate memory for records\n");
+			records_n = 0;
+			return 0;
+		}
+		scan_store(records);
+		qsort(records, (size_t)records_n, sizeof(record_t), compare_records);
+	}
+	return 1;
+}
+
+static int refresh_store(void) {
+	int *store_words_tmp;
+	struct stat status;
+	if (fstat(store_fd, &status)) {
+		flush_log(stderr, "Could not get status of store %s\n", store_path);
+		return 0;
+	}
+	if ((size_t)status.st_size <= store_size || (size_t)status.st_size < sizeof(int)*STORE_HEADER_SIZE) {
+		return 1;
+	}
+	store_words_tmp = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, store_fd, (off_t)0);
+	if (store_words_tmp == MAP_FAILED) {
+		flush_log(stderr, "Could not map store %s\n", store_path);
+		return 0;
+	}
+	if (store_words) {
+		munmap(store_words, store_size);
+	}
+	store_words = store_words_tmp;
+	store_size = (size_t)status.st_size;
+	return index_store();
+}
+
+static int scan_store(record_t *record) {
+	int found_n = 0;
+	size_t words_left = store_size/sizeof(int)-STORE_HEADER_SIZE;
+	const int *words = store_words+STORE_HEADER_SIZE;
+	while (words_left > RECORD_HEADER_SIZE) {
+		if (words[0] == RECORD_MAGIC && words[8] >= 0 && (size_t)words[8] <= words_left/4 && words[1] == RECORD_HEADER_SIZE+words[8]*4+1 && (size_t)words[1] <= words_left && get_checksum(words, words+words[1]-1) == words[words[1]-1]) {
+			if (record) {
+				set_record(record+found_n, words);
+			}
+			++found_n;
+			words_left -= (size_t)words[1];
+			words += words[1];
+		}
+		else {
+			--words_left;
+			++words;
+		}
+	}
+	return found_n;
+}
+
+static int get_checksum(const int *words, const int *words_end) {
+	unsigned checksum = 0U;
+	for (; words < words_end; ++words) {
+		checksum = checksum*CHECKSUM_MUL+(unsigned)*words;
+	}
+	return (int)checksum;
+}
+
+static void lookup_store(int *lower, const record_t **tiling) {
+	int lo = 0, hi = records_n;
+	*lower = -1;
+	*tiling = NULL;
+	while (lo < hi) {
+		int mid = lo+(hi-lo)/2;
+		if (compare_record_key(records+mid) < 0) {
+			lo = mid+1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	for (; lo < records_n && !compare_record_key(records+lo); ++lo) {
+		if (records[lo].kind == RECORD_EXHAUSTED) {
+			if (records[lo].defect_lo <= *lower+1 && records[lo].defect_hi > *lower) {
+				*lower = records[lo].defect_hi;
+			}
+		}
+		else if (!*tiling || records[lo].defect_lo < (*tiling)->defect_lo) {
+			*tiling = records+lo;
+		}
+	}
+}
+
+static int bound_store(int *lower, const record_t **tiling) {
+	if (!refresh_store()) {
+		return 0;
+	}
+	lookup_store(lower, tiling);
+	if (*lower >= defect_b) {
+		defect_b = *lower+1;
+		if (!json_flag) {
+			flush_log(stdout, "Store no solution with defect <= %d\n", *lower);
+		}
+	}
+	if (*tiling && (*tiling)->defect_lo <= defect_cur) {
+		defect_cur = (*tiling)->defect_lo-1;
+		if (!json_flag) {
+			flush_log(stdout, "Store upper bound %d\n", (*tiling)->defect_lo);
+		}
+		if (pair_flag && !set_pair_places(*tiling)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int compare_record_key(const record_t *record) {
+	if (record->height != paint_height) {
+		return record->height < paint_height ? -1:1;
+	}
+	if (record->width != paint_width) {
+		return record->width < paint_width ? -1:1;
+	}
+	if (record->rotate_flag == (rotate_flag ? 1:0)) {
+		return 0;
+	}
+	return record->rotate_flag ? 1:-1;
+}
+
+static int append_record(int height, int width, int rotate, int kind, int defect_lo, int defect_hi, int places_number, const place_t *record_places) {
+	int *words, *word, r, i;
+	size_t words_n = (size_t)(RECORD_HEADER_SIZE+1)+(size_t)places_number*4, size = sizeof(int)*words_n;
+	words = malloc(size);
+	if (!words) {
+		flush_log(stderr, "Could not allocate memory for record\n");
+		return 0;
+	}
+	words[0] = RECORD_MAGIC;
+	words[1] = (int)words_n;
+	words[2] = height;
+	words[3] = width;
+	words[4] = rotate ? 1:0;
+	words[5] = kind;
+	words[6] = defect_lo;
+	words[7] = defect_hi;
+	words[8] = places_number;
+	word = words+RECORD_HEADER_SIZE;
+	for (i = 0; i < places_number; ++i) {
+		*word++ = record_places[i].y_slot;
+		*word++ = record_places[i].x_slot;
+		*word++ = record_places[i].height;
+		*word++ = record_places[i].width;
+	}
+	*word = get_checksum(words, word);
+	r = write(store_fd, words, size) == (ssize_t)size;
+	if (!r) {
+		flush_log(stderr, "Could not append record to store %s\n", store_path);
+	}
+	free(words);
+	return r;
+}
+
+static void print_known(const char *request, const record_t *record) {
+	int i;
+	if (json_flag) {
+		printf("{\"request\":\"%s\",\"height\":%d,\"width\":%d,\"rotate\":%s,\"status\":\"known\",\"defect\":%d,\"tiles\":[", request, paint_height, paint_width, rotate_flag ? "true":"false", record->defect_lo);
+		for (i = 0; i < record->tiles_n; ++i) {
+			printf("%s{\"y\":%d,\"x\":%d,\"height\":%d,\"width\":%d,\"locked\":false}", i ? ",":"", record->tiles[i*4], record->tiles[i*4+1], record->tiles[i*4+2], record->tiles[i*4+3]);
+		}
+		puts("]}");
+		return;
+	}
+	flush_log(stdout, "Store optimal %d\n", record->defect_lo);
+	printf("0 %d %d %d\n", paint_height, paint_width, record->tiles_n);
+	for (i = 0; i < record->tiles_n; ++i) {
+		printf("%dx%d;%dx%d\n", record->tiles[i*4], record->tiles[i*4+1], record->tiles[i*4+2], record->tiles[i*4+3]);
+	}
+	flush_log(stdout, "Defect %d\n", record->defect_lo);
+}
+
+static int set_pair_places(const record_t *record) {
+	int i;
+	if (record->tiles_n > places_max) {
+		place_t *places_tmp = realloc(places, sizeof(place_t)*(size_t)record->tiles_n);
+		if (!places_tmp) {
+			flush_log(stderr, "Could not reallocate memory for places\n");
+			return 0;
+		}
+		places = places_tmp;
+		places_max = record->tiles_n;
+	}
+	for (i = 0; i < record->tiles_n; ++i) {
+		set_place(places+i, record->tiles[i*4], record->tiles[i*4+1], record->tiles[i*4+2], record->tiles[i*4+3], 0);
+	}
+	places_n = record->tiles_n;
+	pair_defect = record->defect_lo;
+	return 1;
+}
+
+static void print_places(void) {
+	int i;
+	printf("0 %d %d %d\n", paint_height, paint_width, places_n);
+	for (i = 0; i < places_n; ++i) {
+		printf("%dx%d;%dx%d\n", places[i].y_slot, places[i].x_slot, places[i].height, places[i].width);
+	}
+	flush_log(stdout, "Defect %d\n", places_defect);
+}
+
+static int is_in_defects(int defect) {
+	return defect_a <= defect_b ? defect >= defect_a && defect <= defect_b:defect >= defect_b && defect <= defect_a;
+}
+
+static void close_store(void) {
+	free(records);
+	if (store_words) {
+		munmap(store_words, store_size);
+	}
+	close(store_fd);
+}
+
+static int run_import(void) {
+	int r = 1;
+	FILE *fd;
+	if (import_path) {
+		fd = fopen(import_path, "r");
+		if (!fd) {
+			flush_log(stderr, "Could not open %s\n", import_path);
+			return 0;
+		}
+		r = import_achievements(fd);
+		fclose(fd);
+		if (r) {
+			flush_log(stdout, "Import %s records %d\n", import_path, imported_n);
+		}
+	}
+	if (r && view_path) {
+		imported_n = 0;
+		fd = fopen(view_path, "r");
+		if (!fd) {
+			flush_log(stderr, "Could not open %s\n", view_path);
+			free(imports);
+			return 0;
+		}
+		r = import_view(fd);
+		fclose(fd);
+		if (r) {
+			flush_log(stdout, "Import %s records %d\n", view_path, imported_n);
+		}
+	}
+	free(imports);
+	return r;
+}
+
+static int import_achievements(FILE *fd) {
+	char line[IMPORT_LINE_SIZE];
+	int rotate = -1, order = 0, order_lo = 0, order_hi = 0, tiling_defect = -1, y_slot, x_slot, height, width, defect, r = 1;
+	while (r && fgets(line, IMPORT_LINE_SIZE, fd)) {
+		if (sscanf(line, "%dx%d;%dx%d", &y_slot, &x_slot, &height, &width) == 4) {
+			r = add_import(y_slot, x_slot, height, width);
+			continue;
+		}
+		if (imports_n) {
+			if (order && rotate >= 0 && tiling_defect >= 0) {
+				r = import_tiling(order, rotate, tiling_defect);
+			}
+			imports_n = 0;
+			tiling_defect = -1;
+		}
+		if (strstr(line, "ROTATE FLAG ON")) {
+			rotate = 1;
+		}
+		else if (strstr(line, "ROTATE FLAG OFF")) {
+			rotate = 0;
+		}
+		else if (sscanf(line, "SQUARES ORDER %d TO %d", &order_lo, &order_hi) == 2) {
+			order = 0;
+		}
+		else if (sscanf(line, "SQUARE ORDER %d", &order) == 1) {
+			order_lo = 0;
+			order_hi = -1;
+		}
+		else if (!strncmp(line, "RECTANGLES", strlen("RECTANGLES"))) {
+			order = 0;
+			order_lo = 0;
+			order_hi = -1;
+		}
+		else if (sscanf(line, "No solution found with defect = %d", &defect) == 1) {
+			r = import_exhausted(order_lo, order_hi, rotate, defect, defect);
+		}
+		else if (sscanf(line, "No solution found with defect <= %d", &defect) == 1) {
+			r = import_exhausted(order_lo, order_hi, rotate, 0, defect);
+		}
+		else if (sscanf(line, "Optimal %d", &defect) == 1) {
+			tiling_defect = defect;
+			if (defect > 0) {
+				r = import_exhausted(order, order, rotate, 0, defect-1);
+			}
+		}
+		else if (sscanf(line, "Upper bound %d", &defect) == 1) {
+			tiling_defect = defect;
+		}
+		else if (sscanf(line, "Lower bound %d", &defect) == 1 && defect > 0) {
+			r = import_exhausted(order, order, rotate, 0, defect-1);
+		}
+	}
+	if (r && imports_n && order && rotate >= 0 && tiling_defect >= 0) {
+		r = import_tiling(order, rotate, tiling_defect);
+	}
+	return r;
+}
+
+static int import_view(FILE *fd) {
+	char line[IMPORT_LINE_SIZE], *cells;
+	int line_flag = fgets(line, IMPORT_LINE_SIZE, fd) != NULL, order, defect, i, j, height, width;
+	while (line_flag) {
+		if (sscanf(line, "a(%d)=%d", &order, &defect) != 2) {
+			line_flag = fgets(line, IMPORT_LINE_SIZE, fd) != NULL;
+			continue;
+		}
+		if (order < 1 || order > IMPORT_LINE_SIZE-2 || defect < 0) {
+			flush_log(stderr, "Invalid entry a(%d)=%d\n", order, defect);
+			return 0;
+		}
+		if (defect && !import_exhausted(order, order, view_rotate_flag, 0, defect-1)) {
+			return 0;
+		}
+		cells = malloc((size_t)(order*order));
+		if (!cells) {
+			flush_log(stderr, "Could not allocate memory for cells\n");
+			return 0;
+		}
+		for (i = 0; i < order && (line_flag = fgets(line, IMPORT_LINE_SIZE, fd) != NULL) && strcspn(line, "\r\n") == (size_t)order; ++i) {
+			memcpy(cells+i*order, line, (size_t)order);
+		}
+		if (i < order) {
+			flush_log(stderr, "Invalid paint for a(%d)\n", order);
+			free(cells);
+			continue;
+		}
+		for (i = 0; i < order*order; ++i) {
+			if (cells[i]) {
+				for (width = 1; i%order+width < order && cells[i+width] == cells[i]; ++width);
+				for (height = 1; i/order+height < order && is_symbol_row(cells+i+height*order, width, cells[i]); ++height);
+				if (!add_import(i/order, i%order, height, width)) {
+					free(cells);
+					return 0;
+				}
+				for (j = height; j--; ) {
+					memset(cells+i+j*order, 0, (size_t)width);
+				}
+			}
+		}
+		free(cells);
+		if (!import_tiling(order, view_rotate_flag, defect)) {
+			return 0;
+		}
+		line_flag = fgets(line, IMPORT_LINE_SIZE, fd) != NULL;
+	}
+	return 1;
+}
+
+static int import_exhausted(int order_lo, int order_hi, int rotate, int defect_lo, int defect_hi) {
+	int order;
+	if (rotate < 0) {
+		return 1;
+	}
+	for (order = order_lo; order > 0 && order <= order_hi; ++order) {
+		if (!append_record(order, order, rotate, RECORD_EXHAUSTED, defect_lo, defect_hi, 0, NULL)) {
+			return 0;
+		}
+		++imported_n;
+	}
+	return 1;
+}
+
+static int is_symbol_row(const char *row, int width, int symbol) {
+	int i;
+	for (i = 0; i < width && row[i] == symbol; ++i);
+	return i == width;
+}
+
+static int add_import(int y_slot, int x_slot, int height, int width) {
+	if (imports_n == imports_max) {
+		place_t *imports_tmp = realloc(imports, sizeof(place_t)*(size_t)(imports_max+PREFIXES_MIN));
+		if (!imports_tmp) {
+			flush_log(stderr, "Could not reallocate memory for imports\n");
+			return 0;
+		}
+		imports = imports_tmp;
+		imports_max += PREFIXES_MIN;
+	}
+	set_place(imports+imports_n, y_slot, x_slot, height, width, 0);
+	++imports_n;
+	return 1;
+}
+
+static int import_tiling(int order, int rotate, int defect) {
+	int area_min = INT_MAX, area_max = 0, area_sum = 0, r, i, j;
+	char *cells;
+	for (i = 0; i < imports_n && imports[i].y_slot >= 0 && imports[i].x_slot >= 0 && imports[i].height > 0 && imports[i].width > 0 && imports[i].height <= order-imports[i].y_slot && imports[i].width <= order-imports[i].x_slot; ++i) {
+		int area = imports[i].height*imports[i].width;
+		if (area < area_min) {
+			area_min = area;
+		}
+		if (area > area_max) {
+			area_max = area;
+		}
+		area_sum += area;
+	}
+	r = i == imports_n && area_sum == order*order && area_max-area_min == defect;
+	if (r) {
+		cells = calloc((size_t)area_sum, 1UL);
+		if (!cells) {
+			flush_log(stderr, "Could not allocate memory for cells\n");
+			imports_n = 0;
+			return 0;
+		}
+		for (i = 0; i < imports_n && r; ++i) {
+			for (j = 0; j < imports[i].height*imports[i].width && r; ++j) {
+				char *cell = cells+(imports[i].y_slot+j/imports[i].width)*order+imports[i].x_slot+j%imports[i].width;
+				r = !*cell;
+				*cell = 1;
+			}
+		}
+		free(cells);
+	}
+	if (r) {
+		r = append_record(order, order, rotate, RECORD_TILING, defect, defect, imports_n, imports);
+		imported_n += r;
+		imports_n = 0;
+		return r;
+	}
+	flush_log(stderr, "Invalid tiling for order %d defect %d\n", order, defect);
+	imports_n = 0;
+	return 1;
+}
+
+static int alloc_paint(void) {
+	if (paint_height > AREA_MAX/paint_width) {
+		flush_log(stderr, "Paint %dx%d is too large\n", paint_height, paint_width);
+		return 0;
+	}
+	paint_area = (area_t)paint_height*paint_width;
+#ifdef MONDRIAN_LEAN
+	counts = malloc(sizeof(count_t)*(size_t)COUNTS_MIN);
+	counts_max = COUNTS_MIN;
+#else
+	if (SIZE_T_MAX/(unsigned)paint_area < sizeof(int)) {
+		flush_log(stderr, "Will not be able to allocate memory for counts\n");
+		return 0;
+	}
+	counts = calloc((size_t)paint_area, sizeof(int));
+#endif
+	windows_n = 0;
+	bound_defect = -1;
+	if (!counts) {
+		flush_log(stderr, "Could not allocate memory for counts\n");
+		return 0;
+	}
+	fits_n = (paint_height > paint_width ? paint_height:paint_width)+1;
+	bars = malloc(sizeof(bar_t)*(size_t)fits_n);
+	if (!bars) {
+		flush_log(stderr, "Could not allocate memory for bars\n");
+		free(counts);
+		return 0;
+	}
+	bars_header = bars+fits_n-1;
+	insert_bar(bars, bars_header, bars_header);
+	ledges = calloc((size_t)(paint_height > paint_width ? paint_height:paint_width), sizeof(ledge_t));
+	if (!ledges) {
+		flush_log(stderr, "Could not allocate memory for ledges\n");
+		free(bars);
+		free(counts);
+		return 0;
+	}
+	width_fits = malloc(sizeof(unsigned long)*(size_t)fits_n*5);
+	if (!width_fits) {
+		flush_log(stderr, "Could not allocate memory for fits\n");
+		free(ledges);
+		free(bars);
+		free(counts);
+		return 0;
+	}
+	height_fits = width_fits+fits_n;
+	yh_fits = height_fits+fits_n;
+	yw_fits = yh_fits+fits_n;
+	y_rows = yw_fits+fits_n;
+	return 1;
+}
+
+static int estimate_paint(paint_t *paint) {
+	int r;
+	unsigned long nodes_start = nodes_n;
+	double time_start = get_time(), nodes, tilings;
+	srand(PROBES_SEED);
+	paint->nodes = 0.0;
+	defect_cur = defect_a;
+	if (defect_a <= defect_b) {
+		do {
+			nodes = 0.0;
+			tilings = 0.0;
+			r = 0;
+			for (options_cur = options_lo; options_cur <= options_hi && !r && tilings <= 0.0; ++options_cur) {
+				r = estimate_defect(&nodes, &tilings);
+			}
+			if (r < 0) {
+				return r;
+			}
+			if (verbose_flag) {
+				flush_log(stdout, "Estimate defect %d nodes %.3e tilings %.3e\n", defect_cur, nodes, tilings);
+			}
+			paint->nodes += nodes/(1.0+tilings);
+			++defect_cur;
+		}
+		while (tilings <= 0.0 && defect_cur <= defect_b);
+	}
+	else {
+		nodes = 0.0;
+		tilings = 0.0;
+		r = 0;
+		for (options_cur = options_lo; options_cur <= options_hi && !r; ++options_cur) {
+			r = estimate_defect(&nodes, &tilings);
+		}
+		if (r < 0) {
+			return r;
+		}
+		paint->nodes = nodes;
+	}
+	paint->seconds = nodes_n > nodes_start ? paint->nodes*(get_time()-time_start)/(double)(nodes_n-nodes_start):0.0;
+	return 0;
+}
+
+static int estimate_defect(double *nodes, double *tilings) {
+	int r = check_bounds(), i;
+	double probes_nodes, time_start;
+	if (r == 1) {
+		r = set_tiles();
+	}
+	if (r != 1) {
+		return r;
+	}
+	probes_nodes = 0.0;
+	probes_tilings = 0.0;
+	time_start = get_time();
+	for (i = 0; i < probes_n; ++i) {
+		mondrian_tiles_n = 0;
+		tile_stop = 0;
+		tiles_area = 0;
+		conflicts_mask = NULL;
+		probes_nodes += probe_mondrian_tile(0, paint_height == paint_width, 1.0);
+	}
+	stats.sets_seconds += get_time()-time_start;
+	*nodes += probes_nodes/probes_n;
+	*tilings += probes_tilings/probes_n;
+	return 0;
+}
+
+static double probe_mondrian_tile(int tiles_start, int sym_flag, double weight) {
+	int candidates_n = 0, candidate = 0, candidate_sym_flag = 0, candidate_tile_stop = 0, i;
+	double nodes = weight;
+	unsigned long *conflicts_start = conflicts_mask;
+	++nodes_n;
+	for (i = tiles_start; i < tiles_n; ++i) {
+		int r = check_mondrian_tile(i, &sym_flag);
+		if (r < 0) {
+			break;
+		}
+		if (r) {
+			++candidates_n;
+			if (rand()%candidates_n == 0) {
+				candidate = i;
+				candidate_sym_flag = sym_flag;
+				candidate_tile_stop = tile_stop;
+			}
+		}
+	}
+	if (!candidates_n) {
+		return nodes;
+	}
+	tile_stop = candidate_tile_stop;
+	weight *= candidates_n;
+	if (tiles[candidate].conflict >= 0) {
+		push_conflicts(candidate);
+	}
+	mondrian_tiles[mondrian_tiles_n++] = tiles+candidate;
+	tiles_area += tiles[candidate].area;
+	if (tiles_area < paint_area) {
+		if (mondrian_tiles_n < options_cur) {
+			nodes += probe_mondrian_tile(candidate+1, candidate_sym_flag, weight);
+		}
+	}
+	else if (mondrian_tiles_n == options_cur) {
+		mondrian_defect = (int)(mondrian_tiles[0]->area-tiles[candidate].area);
+		if (defect_a <= defect_b ? mondrian_defect == defect_cur:mondrian_defect >= defect_b && mondrian_defect <= defect_cur) {
+			unsigned long nodes_start = nodes_n;
+			set_budget(PROBE_NODES_MAX, 0);
+			if (is_mondrian()) {
+				probes_tilings += weight;
+			}
+			set_budget(0UL, 0);
+			nodes += weight*(double)(nodes_n-nodes_start);
+		}
+	}
+	tiles_area -= tiles[candidate].area;
+	--mondrian_tiles_n;
+	conflicts_mask = conflicts_start;
+	return nodes;
+}
+
+static int search_defect(void) {
+	int r = check_bounds();
+	double time_start;
+	if (r == 1) {
+		r = set_tiles();
+	}
+	if (r != 1) {
+		return r;
+	}
+	mondrian_tiles_n = 0;
+	tile_stop = 0;
+	tiles_area = 0;
+	conflicts_mask = NULL;
+	time_start = get_time();
+	TELEMETRY(set_branches(PHASE_SETS, 0));
+	r = add_mondrian_tile(0, paint_height == paint_width);
+	TELEMETRY(close_branches(PHASE_SETS, 0));
+	stats.sets_seconds += get_time()-time_start;
+	return tilings_error ? -1:r;
+}
+
+static int check_bounds(void) {
+	if (defect_cur > bound_defect || options_cur < bound_options) {
+		return 1;
+	}
+	if (options_cur > bound_hi) {
+		return NOT_ENOUGH_TILES;
+	}
+	return options_cur >= bound_lo;
+}
+
+static int set_tiles(void) {
+	int width, height;
+	area_t area;
+	double time_start = get_time();
+	++stats.tiles_n;
+	clear_counts();
+	set_windows();
+	for (width = 1; width < paint_height; ++width) {
+		for (height = next_height(width, 1); height < width; height = next_height(width, height+1)) {
+			area = (area_t)height*width;
+			if (is_valid_area(area)) {
+				if (rotate_flag) {
+					if ((check_tile1(width, height, area) || check_tile1(height, width, area))) {
+						add_count(area);
+					}
+				}
+				else {
+					if (check_tile1(width, height, area)) {
+						add_count(area);
+					}
+					if (check_tile1(height, width, area)) {
+						add_count(area);
+					}
+				}
+			}
+		}
+		area = (area_t)width*width;
+		if (check_tile1(width, width, area) && is_valid_area(area)) {
+			add_count(area);
+		}
+	}
+	if (paint_height < paint_width) {
+		for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+			area = (area_t)height*width;
+			if (is_valid_area(area)) {
+				if (rotate_flag) {
+					if ((check_tile1(height, width, area) || check_big_tile1(paint_width, height, width, area))) {
+						add_count(area);
+					}
+				}
+				else {
+					if (check_tile1(height, width, area)) {
+						add_count(area);
+					}
+					if (check_big_tile1(paint_width, height, width, area)) {
+						add_count(area);
+					}
+				}
+			}
+		}
+		area = (area_t)width*width;
+		if (check_big_tile1(paint_width, width, width, area) && is_valid_area(area)) {
+			add_count(area);
+		}
+		for (++width; width < paint_width; ++width) {
+			for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+				area = (area_t)height*width;
+				if (check_tile1(height, width, area) && is_valid_area(area)) {
+					add_count(area);
+				}
+			}
+			area = (area_t)paint_height*width;
+			if (check_big_tile1(paint_width, width, paint_height, area) && is_valid_area(area)) {
+				add_count(area);
+			}
+		}
+		for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+			area = (area_t)height*width;
+			if (check_big_tile1(paint_height, height, width, area) && is_valid_area(area)) {
+				add_count(area);
+			}
+		}
+	}
+	else {
+		for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+			area = (area_t)height*width;
+			if (check_big_tile1(paint_width, height, width, area) && is_valid_area(area)) {
+				add_count(area);
+				if (!rotate_flag) {
+					add_count(area);
+				}
+			}
+		}
+	}
+	if (!check_counts()) {
+		return -1;
+	}
+	if (!probes_n && !json_flag) {
+		flush_log(stdout, "Current %d Tiles %d\n", defect_cur, tiles_n);
+	}
+	if (tiles_n >= options_cur) {
+		if (tiles_n > tiles_max) {
+			tile_t *tiles_tmp = realloc(tiles, sizeof(tile_t)*(size_t)tiles_n);
+			if (!tiles_tmp) {
 				flush_log(stderr, "Could not reallocate memory for tiles\n");
 				return -1;
 			}
@@ -346,11 +2461,11 @@ static int search_defect(void) {
 			tiles_max = tiles_n;
 		}
 		tiles_n = 0;
+		nogoods_n = 0;
 		for (width = 1; width < paint_height; ++width) {
-			area = 0;
-			for (height = 1; height < width; ++height) {
-				area += width;
-				if (counts[area-1]) {
+			for (height = next_height(width, 1); height < width; height = next_height(width, height+1)) {
+				area = (area_t)height*width;
+				if (get_count(area)) {
 					if (rotate_flag) {
 						if ((check_tile1(width, height, area) || check_tile1(height, width, area))) {
 							add_tile(height, width);
@@ -366,16 +2481,15 @@ static int search_defect(void) {
 					}
 				}
 			}
-			area += width;
-			if (counts[area-1] && check_tile1(width, width, area)) {
+			area = (area_t)width*width;
+			if (get_count(area) && check_tile1(width, width, area)) {
 				add_tile(width, width);
 			}
 		}
-		area = 0;
 		if (paint_height < paint_width) {
-			for (height = 1; height < paint_height; ++height) {
-				area += width;
-				if (counts[area-1]) {
+			for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+				area = (area_t)height*width;
+				if (get_count(area)) {
 					if (rotate_flag) {
 						if ((check_tile1(height, width, area) || check_big_tile1(paint_width, height, width, area))) {
 							add_tile(height, width);
@@ -391,35 +2505,33 @@ static int search_defect(void) {
 					}
 				}
 			}
-			area += width;
-			if (counts[area-1] && check_big_tile1(paint_width, width, width, area)) {
+			area = (area_t)width*width;
+			if (get_count(area) && check_big_tile1(paint_width, width, width, area)) {
 				add_tile(width, width);
 			}
 			for (++width; width < paint_width; ++width) {
-				area = 0;
-				for (height = 1; height < paint_height; ++height) {
-					area += width;
-					if (counts[area-1] && check_tile1(height, width, area)) {
+				for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+					area = (area_t)height*width;
+					if (get_count(area) && check_tile1(height, width, area)) {
 						add_tile(height, width);
 					}
 				}
-				area += width;
-				if (counts[area-1] && check_big_tile1(paint_width, width, height, area)) {
-					add_tile(height, width);
+				area = (area_t)paint_height*width;
+				if (get_count(area) && check_big_tile1(paint_width, width, paint_height, area)) {
+					add_tile(paint_height, width);
 				}
 			}
-			area = 0;
-			for (height = 1; height < paint_height; ++height) {
-				area += width;
-				if (counts[area-1] && check_big_tile1(paint_height, height, width, area)) {
+			for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+				area = (area_t)height*width;
+				if (get_count(area) && check_big_tile1(paint_height, height, width, area)) {
 					add_tile(height, width);
 				}
 			}
 		}
 		else {
-			for (height = 1; height < paint_height; ++height) {
-				area += width;
-				if (counts[area-1] && check_big_tile1(paint_width, height, width, area)) {
+			for (height = next_height(width, 1); height < paint_height; height = next_height(width, height+1)) {
+				area = (area_t)height*width;
+				if (get_count(area) && check_big_tile1(paint_width, height, width, area)) {
 					add_tile(height, width);
 					if (!rotate_flag) {
 						add_tile(width, height);
@@ -427,172 +2539,599 @@ static int search_defect(void) {
 				}
 			}
 		}
-		qsort(tiles, (size_t)tiles_n, sizeof(tile_t), compare_tiles);
-		mondrian_tiles_n = 0;
-		tile_stop = 0;
-		tiles_area = 0;
-		return add_mondrian_tile(0, paint_height == paint_width);
+		qsort(tiles, (size_t)tiles_n, sizeof(tile_t), compare_tiles);
+		for (width = 0; width < tiles_n; ++width) {
+			tiles[width].areas_sum = (width ? tiles[width-1].areas_sum:0UL)+(unsigned long)tiles[width].area;
+		}
+		set_bounds();
+		set_conflicts();
+		stats.tiles_seconds += get_time()-time_start;
+		return check_bounds();
+	}
+	stats.tiles_seconds += get_time()-time_start;
+	return NOT_ENOUGH_TILES;
+}
+
+static void set_bounds(void) {
+	int i, j = 0, k = 0, l = 0, m, n;
+	area_t area_hi = 0, area_lo = 0;
+	bound_defect = defect_cur;
+	bound_options = options_cur;
+	bound_lo = INT_MAX;
+	bound_hi = 0;
+	for (i = 0; i < tiles_n; i = m) {
+		for (m = i; m < tiles_n && tiles[m].area == tiles[i].area; ++m) {
+			area_lo += tiles[m].area;
+		}
+		for (; area_lo > paint_area; ++l) {
+			area_lo -= tiles[l].area;
+		}
+		for (; tiles[j].area > tiles[i].area+defect_cur; ++j) {
+			if (k > j) {
+				area_hi -= tiles[j].area;
+			}
+			else {
+				++k;
+			}
+		}
+		for (; k < m && area_hi < paint_area; ++k) {
+			area_hi += tiles[k].area;
+		}
+		n = l > j ? l:j;
+		if (area_hi >= paint_area && k-j <= m-n) {
+			if (k-j < bound_lo) {
+				bound_lo = k-j;
+			}
+			if (m-n > bound_hi) {
+				bound_hi = m-n;
+			}
+		}
+	}
+}
+
+static void set_windows(void) {
+	int k;
+	windows_n = 0;
+	for (k = options_hi+1; k >= options_cur; --k) {
+		area_t lo = paint_area-(area_t)(k-1)*defect_cur, hi = (paint_area+(area_t)(k-1)*defect_cur)/k;
+		lo = lo > 0 ? (lo-1)/k+1:1;
+		if (hi > paint_area) {
+			hi = paint_area;
+		}
+		if (lo <= hi) {
+			if (windows_n && lo <= windows[windows_n-1].hi+1) {
+				if (hi > windows[windows_n-1].hi) {
+					windows[windows_n-1].hi = hi;
+				}
+			}
+			else {
+				windows[windows_n].lo = lo;
+				windows[windows_n].hi = hi;
+				++windows_n;
+			}
+		}
+	}
+}
+
+static int next_height(int width, int height) {
+	int i = 0;
+	area_t area = (area_t)height*width;
+	for (;;) {
+		for (; i < windows_n && windows[i].hi < area; ++i);
+		if (i == windows_n || windows[i].lo > (area_t)paint_height*width) {
+			return INT_MAX;
+		}
+		if (windows[i].lo <= area) {
+			return height;
+		}
+		height = (int)((windows[i].lo-1)/width)+1;
+		area = (area_t)height*width;
+	}
+}
+
+static int is_valid_area(area_t area) {
+	area_t area_div = paint_area/area, area_mod, others_n;
+	if (area_div < options_cur) {
+		return check_defect(area, area+(area-paint_area)/(options_cur-1), -1);
+	}
+	if (area_div > options_hi) {
+		return check_defect(area, check_area_div(paint_area-area, (area_t)options_hi-1)-area, 1);
+	}
+	area_mod = paint_area%area;
+	others_n = area_div-1;
+	if (check_defect(area, check_area_div(area_mod, others_n), 1)) {
+		return 1;
+	}
+	return check_defect(area, area+(area-paint_area)/area_div, -1);
+}
+
+static int check_defect(area_t area, area_t defect, int sign) {
+	while (defect <= defect_cur && !is_valid_tile(area+defect*sign)) {
+		++defect;
+	}
+	return defect <= defect_cur;
+}
+
+static area_t check_area_div(area_t area, area_t div) {
+	return area%div ? area/div+1:area/div;
+}
+
+static int is_valid_tile(area_t area) {
+	int height;
+	for (height = area > paint_width ? (int)((area-1)/paint_width)+1:1; height <= paint_height && (area_t)height*height <= area; ++height) {
+		if (area%height == 0 && area/height <= paint_width) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int check_tile1(int height, int width, area_t area) {
+	return check_tile2(area, paint_height-height, paint_width, height, paint_width-width) || check_tile2(area, paint_height-height, width, paint_height, paint_width-width);
+}
+
+static int check_tile2(area_t area, int height_delta, int width, int height, int width_delta) {
+	return area-(area_t)height_delta*width <= defect_cur && area-(area_t)height*width_delta <= defect_cur;
+}
+
+static int check_big_tile1(int paint_len, int len, int big_len, area_t area) {
+	int delta = paint_len-len;
+	if (delta != len) {
+		return area-(area_t)delta*big_len <= defect_cur;
+	}
+	if (delta < big_len) {
+		return check_big_tile2(big_len, area, delta);
+	}
+	return check_big_tile2(delta, area, big_len);
+}
+
+static int check_big_tile2(int big_len, area_t area, int delta) {
+	return area-(area_t)delta*(big_len/2-1+big_len%2) <= defect_cur;
+}
+
+#ifdef MONDRIAN_LEAN
+static void clear_counts(void) {
+	counts_n = 0;
+	counts_error = 0;
+}
+
+static void add_count(area_t area) {
+	if (counts_n && counts[counts_n-1].area == area) {
+		++counts[counts_n-1].count;
+		return;
+	}
+	if (counts_n == counts_max) {
+		count_t *counts_tmp;
+		if (counts_error) {
+			return;
+		}
+		counts_tmp = realloc(counts, sizeof(count_t)*(size_t)counts_max*2);
+		if (!counts_tmp) {
+			counts_error = 1;
+			return;
+		}
+		counts = counts_tmp;
+		counts_max *= 2;
+	}
+	counts[counts_n].area = area;
+	counts[counts_n].count = 1;
+	++counts_n;
+}
+
+static int get_count(area_t area) {
+	if (counts_idx && counts[counts_idx-1].area >= area) {
+		counts_idx = 0;
+	}
+	while (counts_idx < counts_n && counts[counts_idx].area < area) {
+		++counts_idx;
+	}
+	return counts_idx < counts_n && counts[counts_idx].area == area ? counts[counts_idx].count:0;
+}
+
+static int check_counts(void) {
+	int i, j, k, counts_sum = 0;
+	area_t counts_area = 0;
+	if (counts_error) {
+		flush_log(stderr, "Could not reallocate memory for counts\n");
+		return 0;
+	}
+	qsort(counts, (size_t)counts_n, sizeof(count_t), compare_counts);
+	for (i = 0, j = 1; j < counts_n; ++j) {
+		if (counts[j].area == counts[i].area) {
+			counts[i].count += counts[j].count;
+		}
+		else {
+			counts[++i] = counts[j];
+		}
+	}
+	if (counts_n) {
+		counts_n = i+1;
+	}
+	tiles_n = 0;
+	for (i = 0, j = 0, k = -1; i < counts_n; ++i) {
+		for (; j < counts_n && counts[j].area <= counts[i].area+defect_cur; ++j) {
+			counts_sum += counts[j].count;
+			counts_area += counts[j].area*counts[j].count;
+		}
+		if (counts_sum >= options_cur && counts_area >= paint_area) {
+			k = i;
+		}
+		counts_sum -= counts[i].count;
+		counts_area -= counts[i].area*counts[i].count;
+		if (k >= 0 && counts[i].area-counts[k].area <= defect_cur) {
+			tiles_n += counts[i].count;
+		}
+		else {
+			counts[i].count = 0;
+		}
+	}
+	for (i = 0, j = 0; j < counts_n; ++j) {
+		if (counts[j].count) {
+			counts[i++] = counts[j];
+		}
+	}
+	counts_n = i;
+	counts_idx = 0;
+	return 1;
+}
+#else
+static void clear_counts(void) {
+	int i;
+	for (i = windows_n; i--; ) {
+		int j;
+		for (j = windows[i].lo-1; j < windows[i].hi; ++j) {
+			counts[j] = 0;
+		}
+	}
+}
+
+static void add_count(area_t area) {
+	++counts[area-1];
+}
+
+static int get_count(area_t area) {
+	return counts[area-1];
+}
+
+static int check_counts(void) {
+	int i, j, k, l, m = -1, counts_sum = 0;
+	long counts_area = 0;
+	tiles_n = 0;
+	if (!windows_n) {
+		return 1;
+	}
+	for (i = 0, k = 0, l = windows[0].lo-1; i < windows_n; ++i) {
+		for (j = windows[i].lo-1; j < windows[i].hi; ++j) {
+			if (!counts[j]) {
+				continue;
+			}
+			while (k < windows_n && l <= j+defect_cur) {
+				counts_sum += counts[l];
+				counts_area += (long)(l+1)*counts[l];
+				if (++l == windows[k].hi && ++k < windows_n) {
+					l = windows[k].lo-1;
+				}
+			}
+			if (counts_sum >= options_cur && counts_area >= paint_area) {
+				m = j;
+			}
+			counts_sum -= counts[j];
+			counts_area -= (long)(j+1)*counts[j];
+			if (m >= 0 && j-m <= defect_cur) {
+				tiles_n += counts[j];
+			}
+			else {
+				counts[j] = 0;
+			}
+		}
+	}
+	return 1;
+}
+#endif
+
+static void add_tile(int height, int width) {
+	set_tile(tiles+tiles_n, height, width);
+	++tiles_n;
+}
+
+static unsigned long sum_tiles(int tiles_lo, int tiles_hi) {
+	return tiles[tiles_hi-1].areas_sum-tiles[tiles_lo].areas_sum+(unsigned long)tiles[tiles_lo].area;
+}
+
+static int add_mondrian_tile(int tiles_start, int sym_flag) {
+	int i;
+	unsigned long *conflicts_start = conflicts_mask;
+	if (++nodes_n > nodes_max && !is_in_budget()) {
+		return 0;
+	}
+	for (i = tiles_start; i < tiles_n; ++i) {
+		int r = check_mondrian_tile(i, &sym_flag);
+		if (r < 0) {
+			return 0;
+		}
+		if (!r) {
+			continue;
+		}
+		TELEMETRY(add_branch(PHASE_SETS, mondrian_tiles_n));
+		if (tiles[i].conflict >= 0) {
+			push_conflicts(i);
+		}
+		mondrian_tiles[mondrian_tiles_n++] = tiles+i;
+		tiles_area += tiles[i].area;
+		if (mondrian_tiles_n == prefix_depth) {
+			r = visit_prefix(i+1, sym_flag);
+		}
+		if (r > 0) {
+			if (tiles_area < paint_area) {
+				if (mondrian_tiles_n < options_cur) {
+					TELEMETRY(set_branches(PHASE_SETS, mondrian_tiles_n));
+					r = add_mondrian_tile(i+1, sym_flag);
+					TELEMETRY(close_branches(PHASE_SETS, mondrian_tiles_n));
+				}
+				else {
+					r = 0;
+				}
+			}
+			else {
+				if (mondrian_tiles_n == options_cur) {
+					++stats.sets_n;
+					mondrian_defect = (int)(mondrian_tiles[0]->area-tiles[i].area);
+					if (defect_a <= defect_b) {
+						r = mondrian_defect == defect_cur ? is_mondrian():0;
+					}
+					else {
+						if (mondrian_defect >= defect_b && mondrian_defect <= defect_cur && is_mondrian()) {
+							defect_cur = mondrian_defect-1;
+						}
+						r = 0;
+					}
+				}
+				else {
+					r = 0;
+				}
+			}
+		}
+		tiles_area -= tiles[i].area;
+		--mondrian_tiles_n;
+		conflicts_mask = conflicts_start;
+		if (r || timeout_flag) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int visit_prefix(int tiles_start, int sym_flag) {
+	int i;
+	double nodes;
+	if (!split_units) {
+		++prefixes_n;
+		return prefixes_n > prefix_lo && prefixes_n <= prefix_hi;
+	}
+	if (!grow_prefixes()) {
+		return -1;
+	}
+	nodes = 0.0;
+	for (i = 0; i < probes_n && mondrian_tiles_n < options_cur; ++i) {
+		nodes += probe_mondrian_tile(tiles_start, sym_flag, 1.0);
+	}
+	set_prefix(prefixes+prefixes_n, defect_cur, options_cur, nodes/probes_n);
+	++prefixes_n;
+	return 0;
+}
+
+static int grow_prefixes(void) {
+	int prefixes_max_tmp;
+	prefix_t *prefixes_tmp;
+	if (prefixes_n < prefixes_max) {
+		return 1;
+	}
+	prefixes_max_tmp = prefixes_max ? prefixes_max*2:PREFIXES_MIN;
+	prefixes_tmp = realloc(prefixes, sizeof(prefix_t)*(size_t)prefixes_max_tmp);
+	if (!prefixes_tmp) {
+		flush_log(stderr, "Could not reallocate memory for prefixes\n");
+		return 0;
+	}
+	prefixes = prefixes_tmp;
+	prefixes_max = prefixes_max_tmp;
+	return 1;
+}
+
+static int check_mondrian_tile(int i, int *sym_flag) {
+	if (mondrian_tiles_n) {
+		if (i+options_cur > tile_stop+mondrian_tiles_n) {
+			TELEMETRY(add_prune(PRUNE_COUNT, mondrian_tiles_n));
+			return -1;
+		}
+		if (sum_tiles(i, tile_stop)+(unsigned long)tiles_area < (unsigned long)paint_area) {
+			TELEMETRY(add_prune(PRUNE_AREA, mondrian_tiles_n));
+			return -1;
+		}
+		if (sum_tiles(i, i+options_cur-mondrian_tiles_n)+(unsigned long)tiles_area < (unsigned long)paint_area) {
+			TELEMETRY(add_prune(PRUNE_COUNT, mondrian_tiles_n));
+			return -1;
+		}
+		if (*sym_flag) {
+			if (tiles[i].delta >= 0) {
+				if (mondrian_tiles[mondrian_tiles_n-1]->delta > 0) {
+					*sym_flag = 0;
+				}
+			}
+			else {
+				if (mondrian_tiles[mondrian_tiles_n-1]->delta <= 0) {
+					TELEMETRY(add_prune(PRUNE_SYM, mondrian_tiles_n));
+					return 0;
+				}
+				if (tiles[i].height != mondrian_tiles[mondrian_tiles_n-1]->width || tiles[i].width != mondrian_tiles[mondrian_tiles_n-1]->height) {
+					*sym_flag = 0;
+				}
+			}
+		}
+	}
+	else {
+		if (*sym_flag && tiles[i].delta < 0) {
+			TELEMETRY(add_prune(PRUNE_SYM, 0));
+			return 0;
+		}
+		for (; tile_stop < tiles_n && tiles[i].area <= defect_cur+tiles[tile_stop].area; ++tile_stop);
+		if (defect_a <= defect_b) {
+			if (tiles[i].area < defect_cur+tiles[tile_stop-1].area) {
+				TELEMETRY(add_prune(PRUNE_DEFECT, 0));
+				return 0;
+			}
+		}
+		else {
+			if (tiles[i].area < defect_b+tiles[tile_stop-1].area) {
+				TELEMETRY(add_prune(PRUNE_DEFECT, 0));
+				return 0;
+			}
+		}
+	}
+	if (tiles_area+tiles[i].area > paint_area) {
+		TELEMETRY(add_prune(PRUNE_OVERFLOW, mondrian_tiles_n));
+		return 0;
+	}
+	if (conflicts_mask) {
+		int r = check_conflicts(i);
+		if (r < 1) {
+			return r;
+		}
+	}
+	if (tiles[i].nogood >= 0 && is_nogood(i)) {
+		TELEMETRY(add_prune(PRUNE_NOGOOD, mondrian_tiles_n));
+		return 0;
+	}
+	return 1;
+}
+
+static void set_conflicts(void) {
+	int side = paint_height < paint_width ? paint_height:paint_width, i, j;
+	conflicts_words = (tiles_n+CONFLICT_BITS-1)/CONFLICT_BITS;
+	conflicts_n = 0;
+	if (tiles_n > CONFLICTS_TILES_MAX || !grow_conflicts(options_hi*conflicts_words) || !grow_compats(options_hi*(tiles_n+1))) {
+		return;
+	}
+	conflicts_n = options_hi*conflicts_words;
+	cores_n = 2;
+	for (i = 0; i < tiles_n; ++i) {
+		for (j = i+1; j < tiles_n; ++j) {
+			if ((tiles[i].height*2 > side || tiles[i].width*2 > side || tiles[j].height*2 > side || tiles[j].width*2 > side) && !can_share(tiles+i, tiles+j, paint_height, paint_width)) {
+				cores[0] = tiles+i;
+				cores[1] = tiles+j;
+				if (is_core() && (!add_conflict(i, j) || !add_conflict(j, i))) {
+					return;
+				}
+			}
+		}
 	}
-	return NOT_ENOUGH_TILES;
 }
 
-static int is_valid_area(int area) {
-	int area_div = paint_area/area, area_mod, others_n;
-	if (area_div < options_cur) {
-		return check_defect(area, area+(area-paint_area)/(options_cur-1), -1);
+static int grow_conflicts(int words_n) {
+	int conflicts_max_tmp = conflicts_max ? conflicts_max:CONFLICTS_MIN;
+	unsigned long *conflicts_tmp;
+	if (conflicts_max-conflicts_n >= words_n) {
+		return 1;
 	}
-	if (area_div > options_hi) {
-		return check_defect(area, check_area_div(paint_area-area, options_hi-1)-area, 1);
+	while (conflicts_max_tmp-conflicts_n < words_n) {
+		if (conflicts_max_tmp > CONFLICTS_MAX/2) {
+			return 0;
+		}
+		conflicts_max_tmp *= 2;
 	}
-	area_mod = paint_area%area;
-	others_n = area_div-1;
-	if (check_defect(area, check_area_div(area_mod, others_n), 1)) {
-		return 1;
+	conflicts_tmp = realloc(conflicts, sizeof(unsigned long)*(size_t)conflicts_max_tmp);
+	if (!conflicts_tmp) {
+		return 0;
 	}
-	return check_defect(area, area+(area-paint_area)/area_div, -1);
+	conflicts = conflicts_tmp;
+	conflicts_max = conflicts_max_tmp;
+	return 1;
 }
 
-static int check_defect(int area, int defect, int sign) {
-	while (defect <= defect_cur && !is_valid_tile(area+defect*sign)) {
-		++defect;
+static int grow_compats(int compats_n) {
+	int *compat_counts_tmp;
+	unsigned long *compat_areas_tmp;
+	if (compats_max >= compats_n) {
+		return 1;
 	}
-	return defect <= defect_cur;
-}
-
-static int check_area_div(int area, int div) {
-	return area%div ? area/div+1:area/div;
+	compat_counts_tmp = realloc(compat_counts, sizeof(int)*(size_t)compats_n);
+	if (!compat_counts_tmp) {
+		return 0;
+	}
+	compat_counts = compat_counts_tmp;
+	compat_areas_tmp = realloc(compat_areas, sizeof(unsigned long)*(size_t)compats_n);
+	if (!compat_areas_tmp) {
+		return 0;
+	}
+	compat_areas = compat_areas_tmp;
+	compats_max = compats_n;
+	return 1;
 }
 
-static int is_valid_tile(int area) {
-	int height;
-	for (height = 1; height <= paint_height && height*height <= area; ++height) {
-		if (area%height == 0 && area/height <= paint_width) {
-			return 1;
+static int add_conflict(int tile_a, int tile_b) {
+	if (tiles[tile_a].conflict < 0) {
+		if (!grow_conflicts(conflicts_words)) {
+			return 0;
 		}
+		memset(conflicts+conflicts_n, 0, sizeof(unsigned long)*(size_t)conflicts_words);
+		tiles[tile_a].conflict = conflicts_n;
+		conflicts_n += conflicts_words;
 	}
-	return 0;
-}
-
-static int check_tile1(int height, int width, int area) {
-	return check_tile2(area, paint_height-height, paint_width, height, paint_width-width) || check_tile2(area, paint_height-height, width, paint_height, paint_width-width);
-}
-
-static int check_tile2(int area, int height_delta, int width, int height, int width_delta) {
-	return area-height_delta*width <= defect_cur && area-height*width_delta <= defect_cur;
+	conflicts[tiles[tile_a].conflict+tile_b/CONFLICT_BITS] |= 1UL << tile_b%CONFLICT_BITS;
+	return 1;
 }
 
-static int check_big_tile1(int paint_len, int len, int big_len, int area) {
-	int delta = paint_len-len;
-	if (delta != len) {
-		return area-delta*big_len <= defect_cur;
+static void push_conflicts(int tile) {
+	int *prefix_counts = compat_counts+mondrian_tiles_n*(tiles_n+1), i, j;
+	unsigned long *row = conflicts+tiles[tile].conflict, *mask = conflicts+mondrian_tiles_n*conflicts_words, *prefix_areas = compat_areas+mondrian_tiles_n*(tiles_n+1);
+	if (conflicts_mask) {
+		for (i = conflicts_words; i--; ) {
+			mask[i] = conflicts_mask[i] | row[i];
+		}
 	}
-	if (delta < big_len) {
-		return check_big_tile2(big_len, area, delta);
+	else {
+		memcpy(mask, row, sizeof(unsigned long)*(size_t)conflicts_words);
 	}
-	return check_big_tile2(delta, area, big_len);
-}
-
-static int check_big_tile2(int big_len, int area, int delta) {
-	return area-delta*(big_len/2-1+big_len%2) <= defect_cur;
+	conflicts_mask = mask;
+	prefix_areas[0] = 0UL;
+	for (i = 0, j = 0; i < tiles_n; ++i) {
+		prefix_counts[i] = j;
+		if (!is_conflict(i)) {
+			prefix_areas[j+1] = prefix_areas[j]+(unsigned long)tiles[i].area;
+			++j;
+		}
+	}
+	prefix_counts[tiles_n] = j;
 }
 
-static void check_count(int count) {
-	int offset;
-	for (offset = count < defect_cur ? count:defect_cur; offset >= 0; --offset) {
-		int counts_sum = 0, counts_area = 0, count_lo = count-offset, count_hi = defect_cur+count_lo < paint_area ? defect_cur+count_lo:paint_area-1, i;
-		for (i = count_lo; i <= count_hi; ++i) {
-			counts_sum += counts[i];
-			counts_area += (i+1)*counts[i];
-			if (counts_sum >= options_cur && counts_area >= paint_area) {
-				tiles_n += counts[count];
-				return;
-			}
-		}
+static int check_conflicts(int tile) {
+	int depth = (int)(conflicts_mask-conflicts)/conflicts_words, *prefix_counts = compat_counts+depth*(tiles_n+1), last;
+	unsigned long *prefix_areas = compat_areas+depth*(tiles_n+1);
+	if (is_conflict(tile)) {
+		TELEMETRY(add_prune(PRUNE_CONFLICT, mondrian_tiles_n));
+		return 0;
 	}
-	counts[count] = 0;
+	last = prefix_counts[tile]+options_cur-mondrian_tiles_n;
+	if (last > prefix_counts[tile_stop] || prefix_areas[last]-prefix_areas[prefix_counts[tile]]+(unsigned long)tiles_area < (unsigned long)paint_area) {
+		TELEMETRY(add_prune(PRUNE_COUNT, mondrian_tiles_n));
+		return -1;
+	}
+	return 1;
 }
 
-static void add_tile(int height, int width) {
-	set_tile(tiles+tiles_n, height, width);
-	++tiles_n;
+static int is_conflict(int tile) {
+	return (int)(conflicts_mask[tile/CONFLICT_BITS] >> tile%CONFLICT_BITS & 1UL);
 }
 
-static int add_mondrian_tile(int tiles_start, int sym_flag) {
-	int i;
-	for (i = tiles_start; i < tiles_n; ++i) {
-		int r;
-		if (mondrian_tiles_n) {
-			int j;
-			if (i+options_cur > tile_stop+mondrian_tiles_n) {
-				return 0;
-			}
-			r = tiles_area;
-			for (j = i; j < tile_stop && r < paint_area; ++j) {
-				r += tiles[j].area;
-			}
-			if (r < paint_area || j+mondrian_tiles_n > i+options_cur) {
-				return 0;
-			}
-			if (sym_flag) {
-				if (tiles[i].delta >= 0) {
-					if (mondrian_tiles[mondrian_tiles_n-1]->delta > 0) {
-						sym_flag = 0;
-					}
-				}
-				else {
-					if (mondrian_tiles[mondrian_tiles_n-1]->delta <= 0) {
-						continue;
-					}
-					if (tiles[i].height != mondrian_tiles[mondrian_tiles_n-1]->width || tiles[i].width != mondrian_tiles[mondrian_tiles_n-1]->height) {
-						sym_flag = 0;
-					}
-				}
-			}
-		}
-		else {
-			if (sym_flag && tiles[i].delta < 0) {
-				continue;
-			}
-			for (; tile_stop < tiles_n && tiles[i].area <= defect_cur+tiles[tile_stop].area; ++tile_stop);
-			if (defect_a <= defect_b) {
-				if (tiles[i].area < defect_cur+tiles[tile_stop-1].area) {
-					continue;
-				}
-			}
-			else {
-				if (tiles[i].area < defect_b+tiles[tile_stop-1].area) {
-					continue;
-				}
-			}
-		}
-		if (tiles_area+tiles[i].area > paint_area) {
-			continue;
-		}
-		mondrian_tiles[mondrian_tiles_n++] = tiles+i;
-		tiles_area += tiles[i].area;
-		if (tiles_area < paint_area) {
-			r = mondrian_tiles_n < options_cur ? add_mondrian_tile(i+1, sym_flag):0;
-		}
-		else {
-			if (mondrian_tiles_n == options_cur) {
-				mondrian_defect = mondrian_tiles[0]->area-tiles[i].area;
-				if (defect_a <= defect_b) {
-					r = mondrian_defect == defect_cur ? is_mondrian():0;
-				}
-				else {
-					if (mondrian_defect >= defect_b && mondrian_defect <= defect_cur && is_mondrian()) {
-						defect_cur = mondrian_defect-1;
-					}
-					r = 0;
-				}
-			}
-			else {
-				r = 0;
+static int is_nogood(int tile) {
+	int nogood;
+	for (nogood = tiles[tile].nogood; nogood >= 0; nogood = nogoods[nogood]) {
+		int others_n = nogoods[nogood+1], i, j;
+		for (i = 0, j = 0; j < others_n && i < mondrian_tiles_n && mondrian_tiles[i]-tiles <= nogoods[nogood+2+j]; ++i) {
+			if (mondrian_tiles[i]-tiles == nogoods[nogood+2+j]) {
+				++j;
 			}
 		}
-		tiles_area -= tiles[i].area;
-		--mondrian_tiles_n;
-		if (r) {
+		if (j == others_n) {
 			return 1;
 		}
 	}
@@ -600,14 +3139,17 @@ static int add_mondrian_tile(int tiles_start, int sym_flag) {
 }
 
 static int is_mondrian(void) {
-	int r, i;
+	int r, i, *memo;
+	unsigned long nodes_start;
+	double time_start = get_time(), time_y;
 	option_t *option;
+	++stats.packs_n;
 	if (verbose_flag) {
 		flush_log(stdout, "is_mondrian options %d defect %d\n", mondrian_tiles_n, mondrian_defect);
 	}
 	height_max = paint_height;
 	width_max = paint_width;
-	if (height_max < width_max) {
+	if (height_max < width_max && (rotate_flag || !count_flag)) {
 		for (i = 0; i < mondrian_tiles_n && can_rotate(mondrian_tiles[i]); ++i);
 		if (i == mondrian_tiles_n) {
 			int len = height_max;
@@ -615,19 +3157,39 @@ static int is_mondrian(void) {
 			width_max = len;
 		}
 	}
-	do {
-		for (i = 0; i < mondrian_tiles_n; ++i) {
-			r = can_be_locked(mondrian_tiles[i]);
-			if (r < 0) {
-				release_locks();
-				return 0;
+	frame_height = height_max;
+	frame_width = width_max;
+	if (!count_flag) {
+		do {
+			for (i = 0; i < mondrian_tiles_n; ++i) {
+				r = can_be_locked(mondrian_tiles[i]);
+				if (r < 0) {
+					set_core(mondrian_tiles[i], NULL);
+					release_locks();
+					add_nogood();
+					stats.packs_seconds += get_time()-time_start;
+					return 0;
+				}
+				if (r) {
+					break;
+				}
 			}
-			if (r) {
-				break;
+		}
+		while (i < mondrian_tiles_n);
+		for (i = 0; i < mondrian_tiles_n; ++i) {
+			if (mondrian_tiles[i]->rotate_flag < TILE_LOCKED) {
+				int j;
+				for (j = i+1; j < mondrian_tiles_n && (mondrian_tiles[j]->rotate_flag == TILE_LOCKED || can_share(mondrian_tiles[i], mondrian_tiles[j], height_max, width_max)); ++j);
+				if (j < mondrian_tiles_n) {
+					set_core(mondrian_tiles[i], mondrian_tiles[j]);
+					release_locks();
+					add_nogood();
+					stats.packs_seconds += get_time()-time_start;
+					return 0;
+				}
 			}
 		}
 	}
-	while (i < mondrian_tiles_n);
 	options_n = 0;
 	for (i = 0; i < mondrian_tiles_n; ++i) {
 		if (mondrian_tiles[i]->rotate_flag < TILE_LOCKED) {
@@ -635,12 +3197,24 @@ static int is_mondrian(void) {
 			++options_n;
 		}
 	}
+	stats.locks_n += (unsigned long)(mondrian_tiles_n-options_n);
 	if (!options_n) {
 		print_solution();
 		release_locks();
+		stats.packs_seconds += get_time()-time_start;
 		return 1;
 	}
 	qsort(options, (size_t)options_n, sizeof(option_t), compare_options);
+	memo = get_memo();
+	if (is_memo(memo)) {
+		++stats.memos_n;
+		if (verbose_flag) {
+			flush_log(stdout, "is_mondrian memo\n");
+		}
+		release_locks();
+		stats.packs_seconds += get_time()-time_start;
+		return 0;
+	}
 	options_header = options+options_n;
 	for (i = options_n; i--; ) {
 		link_options_y(options+i, options+i+1);
@@ -663,20 +3237,193 @@ static int is_mondrian(void) {
 			option->yw_slot_max = (height_max-option->width)/2;
 		}
 	}
+	set_fits();
 	if (verbose_flag) {
 		mp_new(y_cost);
 	}
 	set_bar(bars, 0, height_max, width_max);
 	set_bar(bars_header, height_max, 0, 0);
 	bars_n = 1;
-	r = search_y_slot(options_n, bars, options);
+	nodes_start = nodes_n;
+	time_y = get_time();
+	TELEMETRY(y_depth = 0);
+	TELEMETRY(set_branches(PHASE_Y, 0));
+	r = rotate_flag ? search_y_slot_rotate(options_n, bars, options):search_y_slot_fixed(options_n, bars, options);
+	TELEMETRY(close_branches(PHASE_Y, 0));
+	stats.y_nodes_n += nodes_n-nodes_start;
+	stats.y_seconds += get_time()-time_y;
 	if (verbose_flag) {
 		mp_print("search_y_slot cost", y_cost);
 	}
+	if (!r && !timeout_flag) {
+		set_memo(memo);
+	}
 	release_locks();
+	stats.packs_seconds += get_time()-time_start;
 	return r;
 }
 
+static int *get_memo(void) {
+	int i;
+	unsigned long hash = (unsigned long)options_n;
+	if (count_flag) {
+		return NULL;
+	}
+	hash = hash*31UL+(unsigned long)height_max;
+	hash = hash*31UL+(unsigned long)width_max;
+	hash = hash*31UL+(unsigned long)rotate_flag;
+	for (i = 0; i < options_n; ++i) {
+		hash = hash*31UL+(unsigned long)options[i].height;
+		hash = hash*31UL+(unsigned long)options[i].width;
+	}
+	return memos+hash%(unsigned long)memos_n*(unsigned long)memo_ints;
+}
+
+static int is_memo(const int *memo) {
+	int i;
+	if (!memo || memo[0] != options_n || memo[1] != height_max || memo[2] != width_max || memo[3] != rotate_flag) {
+		return 0;
+	}
+	for (i = 0; i < options_n && memo[MEMO_KEY+i*2] == options[i].height && memo[MEMO_KEY+i*2+1] == options[i].width; ++i);
+	return i == options_n;
+}
+
+static void set_memo(int *memo) {
+	int i;
+	if (!memo) {
+		return;
+	}
+	memo[0] = options_n;
+	memo[1] = height_max;
+	memo[2] = width_max;
+	memo[3] = rotate_flag;
+	for (i = 0; i < options_n; ++i) {
+		memo[MEMO_KEY+i*2] = options[i].height;
+		memo[MEMO_KEY+i*2+1] = options[i].width;
+	}
+}
+
+static void set_core(tile_t *tile_a, tile_t *tile_b) {
+	int i;
+	cores_n = 0;
+	for (i = 0; i < mondrian_tiles_n; ++i) {
+		if (mondrian_tiles[i]->rotate_flag == TILE_LOCKED || mondrian_tiles[i] == tile_a || mondrian_tiles[i] == tile_b) {
+			cores[cores_n++] = mondrian_tiles[i];
+		}
+	}
+}
+
+static int is_core(void) {
+	int i;
+	memcpy(cores+options_hi, cores, sizeof(tile_t *)*(size_t)cores_n);
+	if (!check_core(cores+options_hi, paint_height, paint_width)) {
+		return 0;
+	}
+	if (paint_height < paint_width && (rotate_flag || !count_flag)) {
+		for (i = 0; i < cores_n && cores[i]->width <= paint_height && cores[i]->height <= paint_width; ++i);
+		if (i == cores_n) {
+			memcpy(cores+options_hi, cores, sizeof(tile_t *)*(size_t)cores_n);
+			return check_core(cores+options_hi, paint_width, paint_height);
+		}
+	}
+	return 1;
+}
+
+static int check_core(tile_t **core, int height, int width) {
+	int locks_n = 0, i, j;
+	do {
+		for (i = locks_n; i < cores_n; ++i) {
+			tile_t *tile = core[i];
+			if (!can_fit(tile, height, width)) {
+				return 1;
+			}
+			if (!tile->rotate_flag && (tile->height == height || tile->width == width)) {
+				if (tile->height == height) {
+					width -= tile->width;
+				}
+				else {
+					height -= tile->height;
+				}
+				core[i] = core[locks_n];
+				core[locks_n++] = tile;
+				break;
+			}
+		}
+	}
+	while (i < cores_n);
+	for (i = locks_n; i < cores_n; ++i) {
+		for (j = i+1; j < cores_n; ++j) {
+			if (!can_share(core[i], core[j], height, width)) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int can_fit(const tile_t *tile, int height, int width) {
+	return (tile->height <= height && tile->width <= width) || (tile->rotate_flag && tile->width <= height && tile->height <= width);
+}
+
+static int can_share(const tile_t *tile_a, const tile_t *tile_b, int height, int width) {
+	int i;
+	for (i = 0; i < 4; ++i) {
+		int height_a = i%2 ? tile_a->width:tile_a->height, width_a = i%2 ? tile_a->height:tile_a->width, height_b = i/2 ? tile_b->width:tile_b->height, width_b = i/2 ? tile_b->height:tile_b->width;
+		if ((!(i%2) || tile_a->rotate_flag) && (!(i/2) || tile_b->rotate_flag) && height_a <= height && width_a <= width && height_b <= height && width_b <= width && (height_a+height_b <= height || width_a+width_b <= width)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void add_nogood(void) {
+	int i, j, *nogood;
+	tile_t *tile;
+	if (nogoods_n >= NOGOODS_MAX || !is_core()) {
+		return;
+	}
+	for (i = cores_n; i--; ) {
+		tile = cores[i];
+		cores[i] = cores[--cores_n];
+		if (!is_core()) {
+			cores[cores_n++] = cores[i];
+			cores[i] = tile;
+		}
+	}
+	if (nogoods_max-nogoods_n <= cores_n) {
+		int nogoods_max_tmp = nogoods_max ? nogoods_max:NOGOODS_MIN, *nogoods_tmp;
+		while (nogoods_max_tmp-nogoods_n <= cores_n) {
+			if (nogoods_max_tmp > INT_MAX/2) {
+				return;
+			}
+			nogoods_max_tmp *= 2;
+		}
+		nogoods_tmp = realloc(nogoods, sizeof(int)*(size_t)nogoods_max_tmp);
+		if (!nogoods_tmp) {
+			return;
+		}
+		nogoods = nogoods_tmp;
+		nogoods_max = nogoods_max_tmp;
+	}
+	for (i = 1; i < cores_n; ++i) {
+		tile = cores[i];
+		for (j = i; j && cores[j-1] > tile; --j) {
+			cores[j] = cores[j-1];
+		}
+		cores[j] = tile;
+	}
+	tile = cores[--cores_n];
+	nogood = nogoods+nogoods_n;
+	*nogood++ = tile->nogood;
+	*nogood++ = cores_n;
+	for (i = cores_n; i--; ) {
+		nogood[i] = (int)(cores[i]-tiles);
+	}
+	tile->nogood = nogoods_n;
+	nogoods_n += cores_n+2;
+	++stats.nogoods_n;
+}
+
 static int can_rotate(const tile_t *tile) {
 	return tile->width <= height_max && tile->height <= width_max;
 }
@@ -712,6 +3459,15 @@ static void release_locks(void) {
 
 static void print_solution(void) {
 	int i;
+	if (probes_n) {
+		return;
+	}
+	if (json_flag || store_path || count_flag || pair_flag) {
+		set_places();
+	}
+	if (json_flag || count_flag) {
+		return;
+	}
 	printf("0 %d %d %d\n", height_max, width_max, solutions_n);
 	for (i = 0; i < solutions_n; ++i) {
 		print_option(solutions[i]);
@@ -731,192 +3487,216 @@ static void print_lock(const tile_t *tile) {
 	}
 }
 
-static int search_y_slot(int bars_hi, bar_t *bar_start, option_t *options_start) {
-	int r, i;
-	if (verbose_flag) {
-		mp_inc(y_cost);
+static void set_places(void) {
+	int height = frame_height, width = frame_width, i;
+	places_n = 0;
+	do {
+		for (i = 0; i < mondrian_tiles_n && (mondrian_tiles[i]->rotate_flag != TILE_LOCKED || (mondrian_tiles[i]->height != height && mondrian_tiles[i]->width != width)); ++i);
+		if (i < mondrian_tiles_n) {
+			if (mondrian_tiles[i]->height == height) {
+				width -= mondrian_tiles[i]->width;
+				set_place(places+places_n, 0, width, mondrian_tiles[i]->height, mondrian_tiles[i]->width, 1);
+			}
+			else {
+				height -= mondrian_tiles[i]->height;
+				set_place(places+places_n, height, 0, mondrian_tiles[i]->height, mondrian_tiles[i]->width, 1);
+			}
+			mondrian_tiles[i]->rotate_flag = TILE_PLACED;
+			++places_n;
+		}
 	}
-	if (bars_hi < bars_n) {
-		return 0;
+	while (i < mondrian_tiles_n);
+	for (i = mondrian_tiles_n; i--; ) {
+		if (mondrian_tiles[i]->rotate_flag == TILE_PLACED) {
+			mondrian_tiles[i]->rotate_flag = TILE_LOCKED;
+		}
 	}
-	if (bar_start != bars_header) {
-		int y_slot = bar_start->y_slot, slot_width = bar_start->x_space, x_max, y_min;
-		option_t *option, *last_chance;
-		bar_t *bar_cur, *bar_cur_next, *bar_start_next, *bar;
-		if (bars_hi == bars_n) {
-			for (option = options_start; option != options_header; option = option->y_next) {
-				if (option->yh_slot_max < y_slot) {
-					return 0;
-				}
-				if (option->width == slot_width) {
-					if (check_next_y_slot(bar_start, y_slot+option->height) && choose_y_slot(bars_hi, bar_start, option, option->height, option->width)) {
-						return 1;
-					}
-				}
-				else if (option->rotate_flag && option->yw_slot_max >= y_slot && option->height == slot_width && check_next_y_slot(bar_start, y_slot+option->width) && choose_y_slot(bars_hi, bar_start, option, option->width, option->height)) {
-					return 1;
-				}
-			}
-			return 0;
+	for (i = 0; i < solutions_n; ++i) {
+		set_place(places+places_n, solutions[i]->y_slot_lo, solutions[i]->x_slot_lo, solutions[i]->slot_height, solutions[i]->slot_width, 0);
+		++places_n;
+	}
+	if (frame_height != paint_height) {
+		for (i = 0; i < places_n; ++i) {
+			set_place(places+i, places[i].x_slot, places[i].y_slot, places[i].width, places[i].height, places[i].locked_flag);
 		}
-		if (bars_hi == bars_n+1) {
-			for (option = options_start; option != options_header; option = option->y_next) {
-				if (option->yh_slot_max < y_slot) {
-					return 0;
-				}
-				if (((option->width == slot_width || (option->width < slot_width && check_next_y_slot(bar_start, y_slot+option->height))) && choose_y_slot(bars_hi, bar_start, option, option->height, option->width)) || (option->rotate_flag && option->yw_slot_max >= y_slot && (option->height == slot_width || (option->height < slot_width && check_next_y_slot(bar_start, y_slot+option->width))) && choose_y_slot(bars_hi, bar_start, option, option->width, option->height))) {
-					return 1;
-				}
-			}
-			return 0;
+	}
+	places_defect = mondrian_defect;
+}
+
+static void clear_tilings(void) {
+	size_t i;
+	tilings_n = 0UL;
+	tilings_words_n = 0;
+	tilings_error = 0;
+	for (i = 0; i < tilings_slots_n; ++i) {
+		tilings_slots[i] = 0;
+	}
+}
+
+static void add_tiling(void) {
+	int transforms_n = paint_height == paint_width ? TRANSFORMS_SQUARE:TRANSFORMS_RECTANGLE, words_n = places_n*4+1, transform, i;
+	const int *word;
+	if (tilings_error) {
+		return;
+	}
+	for (transform = 0; transform < transforms_n; ++transform) {
+		for (i = 0; i < places_n; ++i) {
+			set_symmetric_place(tiling_places+i, places+i, transform);
 		}
-		x_max = 0;
-		y_min = height_max;
-		for (option = options_start; option != options_header; option = option->y_next) {
-			if (option->yh_slot_max < y_slot) {
-				return 0;
-			}
-			if (option->width <= slot_width) {
-				x_max += option->width;
-				if (option->height < y_min) {
-					y_min = option->height;
-				}
-			}
-			else if (option->rotate_flag && option->yw_slot_max >= y_slot && option->height <= slot_width) {
-				x_max += option->height;
-				if (option->width < y_min) {
-					y_min = option->width;
-				}
+		qsort(tiling_places, (size_t)places_n, sizeof(place_t), compare_places);
+		if (transform) {
+			set_tiling_words(tiling_words+words_n);
+			if (compare_tiling_words(tiling_words+words_n, tiling_words, words_n) < 0) {
+				memcpy(tiling_words, tiling_words+words_n, sizeof(int)*(size_t)words_n);
 			}
 		}
-		if (x_max < slot_width) {
-			return 0;
+		else {
+			set_tiling_words(tiling_words);
 		}
-		for (bar_cur = bar_start; bar_cur != bars_header && bar_cur->height <= y_min; bar_cur = bar_cur->next) {
-			y_min -= bar_cur->height;
-			bar_cur->x_space -= slot_width;
-		}
-		bar_cur_next = bar_cur->next;
-		if (y_min) {
-			set_bar(bars+bars_n, bar_cur->y_slot+y_min, bar_cur->height-y_min, bar_cur->x_space);
-			bar_cur->x_space -= slot_width;
-			insert_bar(bars+bars_n, bar_cur, bar_cur_next);
-		}
-		bar_start_next = bar_start->next;
-		last_chance = options_header;
-		for (option = options_header->y_next; option != options_header; option = option->y_next) {
-			if (option->rotate_flag) {
-				for (bar = bar_start_next; bar != bars_header && bar->x_space < option->height; bar = bar->next);
-				if (bar == bars_header || bar->y_slot > option->yw_slot_max) {
-					for (; bar != bars_header && bar->x_space < option->width; bar = bar->next);
-					if (bar == bars_header || bar->y_slot > option->yh_slot_max) {
-						if (option < options_start || ((option->yw_slot_max < y_slot || option->height > slot_width) && option->width > slot_width)) {
-							rollback_y_slot(bar_start, bar_cur, bar_cur_next, y_min, slot_width);
-							return 0;
-						}
-						if (option < last_chance) {
-							last_chance = option;
-						}
-					}
-				}
-			}
-			else {
-				for (bar = bar_start_next; bar != bars_header && bar->x_space < option->width; bar = bar->next);
-				if (bar == bars_header || bar->y_slot > option->yh_slot_max) {
-					if (option < options_start || option->width > slot_width) {
-						rollback_y_slot(bar_start, bar_cur, bar_cur_next, y_min, slot_width);
-						return 0;
-					}
-					if (option < last_chance) {
-						last_chance = option;
-					}
-				}
-			}
+	}
+	if (tilings_n >= tilings_slots_n/2 && !grow_tilings_slots()) {
+		tilings_error = 1;
+		nodes_max = nodes_n;
+		return;
+	}
+	if (tilings_words_max-tilings_words_n < (size_t)words_n) {
+		size_t tilings_words_max_tmp = tilings_words_max ? tilings_words_max*2:TILINGS_WORDS_MIN;
+		int *tilings_words_tmp;
+		if (tilings_words_max_tmp-tilings_words_n < (size_t)words_n) {
+			tilings_words_max_tmp = tilings_words_n+(size_t)words_n;
 		}
-		rollback_y_slot(bar_start, bar_cur, bar_cur_next, y_min, slot_width);
-		for (bar = bar_start->next; bar != bars_header; bar = bar->next) {
-			for (option = options_header->y_next; option != options_header && (option->yh_slot_max < bar->y_slot || option->width > bar->x_space) && (!option->rotate_flag || option->yw_slot_max < bar->y_slot || option->height > bar->x_space); option = option->y_next);
-			if (option == options_header) {
-				return 0;
-			}
+		tilings_words_tmp = realloc(tilings_words, sizeof(int)*tilings_words_max_tmp);
+		if (!tilings_words_tmp) {
+			flush_log(stderr, "Could not reallocate memory for tilings_words\n");
+			tilings_error = 1;
+			nodes_max = nodes_n;
+			return;
+		}
+		tilings_words = tilings_words_tmp;
+		tilings_words_max = tilings_words_max_tmp;
+	}
+	memcpy(tilings_words+tilings_words_n, tiling_words, sizeof(int)*(size_t)words_n);
+	if (!insert_tiling(tilings_words_n)) {
+		return;
+	}
+	tilings_words_n += (size_t)words_n;
+	++tilings_n;
+	printf("0 %d %d %d\n", paint_height, paint_width, places_n);
+	for (word = tiling_words+1, i = 0; i < places_n; word += 4, ++i) {
+		printf("%dx%d;%dx%d\n", word[0], word[1], word[2], word[3]);
+	}
+	flush_log(stdout, "Defect %d\n", mondrian_defect);
+}
+
+static void set_tiling_words(int *words) {
+	int i;
+	*words++ = places_n;
+	for (i = 0; i < places_n; ++i) {
+		*words++ = tiling_places[i].y_slot;
+		*words++ = tiling_places[i].x_slot;
+		*words++ = tiling_places[i].height;
+		*words++ = tiling_places[i].width;
+	}
+}
+
+static int compare_tiling_words(const int *words_a, const int *words_b, int words_n) {
+	const int *words_end = words_a+words_n;
+	for (; words_a < words_end; ++words_a, ++words_b) {
+		if (*words_a != *words_b) {
+			return *words_a < *words_b ? -1:1;
 		}
-		for (option = options_start; option != options_header; option = option->y_next) {
-			if (option->width <= slot_width) {
-				if ((choose_y_slot(bars_hi, bar_start, option, option->height, option->width)) || (option->rotate_flag && option->yw_slot_max >= y_slot && option->height <= slot_width && choose_y_slot(bars_hi, bar_start, option, option->width, option->height))) {
-					return 1;
-				}
-				x_max -= option->width;
-			}
-			else if (option->rotate_flag && option->yw_slot_max >= y_slot && option->height <= slot_width) {
-				if (choose_y_slot(bars_hi, bar_start, option, option->width, option->height)) {
-					return 1;
-				}
-				x_max -= option->height;
-			}
-			if (x_max < slot_width || option == last_chance) {
-				return 0;
-			}
+	}
+	return 0;
+}
+
+static int insert_tiling(size_t offset) {
+	const int *words = tilings_words+offset;
+	int words_n = *words*4+1;
+	size_t slot;
+	for (slot = (size_t)(unsigned)get_checksum(words, words+words_n) & (tilings_slots_n-1); tilings_slots[slot]; slot = (slot+1) & (tilings_slots_n-1)) {
+		const int *tiling = tilings_words+tilings_slots[slot]-1;
+		if (*tiling == *words && !compare_tiling_words(tiling, words, words_n)) {
+			return 0;
 		}
+	}
+	tilings_slots[slot] = offset+1;
+	return 1;
+}
+
+static int grow_tilings_slots(void) {
+	size_t tilings_slots_n_tmp = tilings_slots_n ? tilings_slots_n*2:TILINGS_SLOTS_MIN, *tilings_slots_tmp = calloc(tilings_slots_n_tmp, sizeof(size_t)), offset;
+	if (!tilings_slots_tmp) {
+		flush_log(stderr, "Could not allocate memory for tilings_slots\n");
 		return 0;
 	}
-	for (i = options_n; i--; ) {
-		set_option(options+i);
-		link_options_x(options+i, options+i+1);
+	free(tilings_slots);
+	tilings_slots = tilings_slots_tmp;
+	tilings_slots_n = tilings_slots_n_tmp;
+	for (offset = 0; offset < tilings_words_n; offset += (size_t)(tilings_words[offset]*4+1)) {
+		insert_tiling(offset);
 	}
-	link_options_x(options_header, options);
-	solutions_n = 0;
-	if (verbose_flag) {
-		mp_new(x_cost);
+	return 1;
+}
+
+static void print_json(const char *request, const paint_t *paint, int timeout_status, int timeout_current, int timeout_options, unsigned long nodes, double seconds) {
+	int i;
+	double time_now;
+	printf("{\"request\":\"%s\",\"height\":%d,\"width\":%d,\"rotate\":%s", request, paint_height, paint_width, rotate_flag ? "true":"false");
+	if (paint) {
+		printf(",\"status\":\"estimate\",\"estimate\":{\"nodes\":%.3e,\"seconds\":%.3e}", paint->nodes, paint->seconds);
 	}
-	insert_choice(choices, choices_header, choices_header);
-	choices_hi = choices;
-	r = search_x_slot(choices);
-	link_choices(choices_header, choices_header);
-	if (verbose_flag) {
-		mp_print("search_x_slot cost", x_cost);
+	else {
+		if (timeout_status) {
+			printf(",\"status\":\"timeout\",\"current\":%d,\"options\":%d", timeout_current, timeout_options);
+		}
+		else {
+			printf(",\"status\":\"%s\"", places_defect >= 0 ? "solved":"no_solution");
+		}
+		if (places_defect >= 0) {
+			printf(",\"defect\":%d,\"tiles\":[", places_defect);
+			for (i = 0; i < places_n; ++i) {
+				printf("%s{\"y\":%d,\"x\":%d,\"height\":%d,\"width\":%d,\"locked\":%s}", i ? ",":"", places[i].y_slot, places[i].x_slot, places[i].height, places[i].width, places[i].locked_flag ? "true":"false");
+			}
+			putchar(']');
+		}
+		else {
+			printf(",\"defect\":null");
+		}
+	}
+	printf(",\"stats\":{\"nodes\":%lu,\"seconds\":%.6f,\"tiles_calls\":%lu,\"tiles_seconds\":%.6f,\"sets\":%lu,\"packs\":%lu,\"locks\":%lu,\"y_nodes\":%lu,\"y_seconds\":%.6f,\"x_nodes\":%lu,\"x_seconds\":%.6f}}\n", nodes, seconds, stats.tiles_n, stats.tiles_seconds, stats.sets_n, stats.packs_n, stats.locks_n, stats.y_nodes_n-stats.x_nodes_n, stats.y_seconds-stats.x_seconds, stats.x_nodes_n, stats.x_seconds);
+	time_now = get_time();
+	if (time_now-json_time >= JSON_FLUSH_SECONDS) {
+		fflush(stdout);
+		json_time = time_now;
 	}
-	return r;
 }
 
+#define Y_SLOT_SEARCH search_y_slot_rotate
+#define Y_SLOT_CHOOSE choose_y_slot_rotate
+#define Y_SLOT_FILL can_fill_rotate
+#define Y_SLOT_ROTATE(option) (option)->rotate_flag
+#include "mondrian_y_slot.h"
+#undef Y_SLOT_ROTATE
+#undef Y_SLOT_FILL
+#undef Y_SLOT_CHOOSE
+#undef Y_SLOT_SEARCH
+
+#define Y_SLOT_SEARCH search_y_slot_fixed
+#define Y_SLOT_CHOOSE choose_y_slot_fixed
+#define Y_SLOT_FILL can_fill_fixed
+#define Y_SLOT_ROTATE(option) 0
+#include "mondrian_y_slot.h"
+#undef Y_SLOT_ROTATE
+#undef Y_SLOT_FILL
+#undef Y_SLOT_CHOOSE
+#undef Y_SLOT_SEARCH
+
 static int check_next_y_slot(bar_t *bar_start, int y_slot) {
 	bar_t *bar;
 	for (bar = bar_start->next; bar != bars_header && bar->y_slot < y_slot; bar = bar->next);
 	return bar->y_slot == y_slot;
 }
 
-static int choose_y_slot(int bars_hi, bar_t *bar_start, option_t *option, int slot_height, int slot_width) {
-	int r;
-	bar_t *bar_cur, *bar;
-	option->slot_height = slot_height;
-	option->y_slot_lo = bar_start->y_slot;
-	link_options_y(option->y_last, option->y_next);
-	for (bar_cur = bar_start; bar_cur != bars_header && bar_cur->height <= slot_height; bar_cur = bar_cur->next) {
-		slot_height -= bar_cur->height;
-		bar_cur->x_space -= slot_width;
-	}
-	bar = bar_cur->next;
-	if (slot_height) {
-		set_bar(bars+bars_n, bar_cur->y_slot+slot_height, bar_cur->height-slot_height, bar_cur->x_space);
-		bar_cur->height = slot_height;
-		bar_cur->x_space -= slot_width;
-		insert_bar(bars+bars_n, bar_cur, bar);
-		++bars_n;
-	}
-	r = bar_start->x_space ? search_y_slot(bars_hi-1, bar_start, option->y_next):search_y_slot(bars_hi, bar_start->next, options_header->y_next);
-	if (slot_height) {
-		--bars_n;
-		link_bars(bar_cur, bar);
-		bar_cur->x_space += slot_width;
-		bar_cur->height += bars[bars_n].height;
-	}
-	for (bar = bar_start; bar != bar_cur; bar = bar->next) {
-		bar->x_space += slot_width;
-	}
-	option->y_next->y_last = option;
-	option->y_last->y_next = option;
-	return r;
-}
-
 static void rollback_y_slot(bar_t *bar_start, bar_t *bar_cur, bar_t *bar_cur_next, int y_min, int slot_width) {
 	bar_t *bar;
 	if (y_min) {
@@ -929,66 +3709,106 @@ static void rollback_y_slot(bar_t *bar_start, bar_t *bar_cur, bar_t *bar_cur_nex
 }
 
 static int search_x_slot(choice_t *choices_lo) {
+	if (++nodes_n > nodes_max && !is_in_budget()) {
+		return 0;
+	}
 	if (verbose_flag) {
 		mp_inc(x_cost);
 	}
 	if (options_header->x_next != options_header) {
+		int y_slot, x_slot, ledge_width;
 		option_t *option;
-		for (; choices_lo != choices_header; choices_lo = choices_lo->next) {
-			int i;
-			for (i = 0; i < solutions_n && is_valid_choice(solutions[i], choices_lo->y_slot, choices_lo->x_slot); ++i);
-			if (i == solutions_n) {
-				break;
-			}
-		}
+		for (; choices_lo != choices_header && (!ledges[choices_lo->x_slot].width || ledges[choices_lo->x_slot].y_slot != choices_lo->y_slot); choices_lo = choices_lo->next);
 		if (choices_lo == choices_header) {
+			TELEMETRY(add_prune(PRUNE_CORNER, solutions_n));
 			return 0;
 		}
-		for (option = options_header->x_next; option != options_header; option = option->x_next) {
-			if (option->y_slot_lo == choices_lo->y_slot) {
-				int i;
-				if (option->x_slot_max < choices_lo->x_slot) {
-					return 0;
+		y_slot = choices_lo->y_slot;
+		x_slot = choices_lo->x_slot;
+		ledge_width = ledges[x_slot].width;
+		for (option = get_x_option(options_header, y_slot); option != options_header; option = get_x_option(option, y_slot)) {
+			if (option->x_slot_max < x_slot) {
+				TELEMETRY(add_prune(PRUNE_X_SLOT, solutions_n));
+				return 0;
+			}
+			if (option->slot_width <= ledge_width) {
+				int x_slot_lo = x_slot, width = option->slot_width, width_lo = 0, width_hi = 0, r;
+				TELEMETRY(add_branch(PHASE_X, solutions_n));
+				option->x_slot_lo = x_slot;
+				option->x_slot_hi = x_slot+option->slot_width;
+				link_options_x(option->x_last, option->x_next);
+				x_options ^= option->bit;
+				solutions[solutions_n++] = option;
+				if (option->slot_width < ledge_width) {
+					set_ledge(option->x_slot_hi, ledge_width-option->slot_width, y_slot);
 				}
-				for (i = 0; i < solutions_n && (choices_lo->y_slot >= solutions[i]->y_slot_hi || choices_lo->x_slot >= solutions[i]->x_slot_hi || choices_lo->x_slot+option->slot_width <= solutions[i]->x_slot_lo); ++i);
-				if (i == solutions_n) {
-					int r;
-					option->x_slot_lo = choices_lo->x_slot;
-					option->x_slot_hi = choices_lo->x_slot+option->slot_width;
-					link_options_x(option->x_last, option->x_next);
-					solutions[solutions_n++] = option;
-					if (option->y_slot_hi < height_max) {
-						add_choice(option->y_slot_hi, option->x_slot_lo);
-					}
-					if (option->x_slot_hi < width_max) {
-						add_choice(option->y_slot_lo, option->x_slot_hi);
-					}
-					r = search_x_slot(choices_lo->next);
-					if (option->x_slot_hi < width_max) {
-						link_choices(choices_hi->last, choices_hi->next);
-						--choices_hi;
-					}
-					if (option->y_slot_hi < height_max) {
-						link_choices(choices_hi->last, choices_hi->next);
-						--choices_hi;
-					}
-					--solutions_n;
-					option->x_next->x_last = option;
-					option->x_last->x_next = option;
-					if (r) {
-						return r;
-					}
+				else if (option->x_slot_hi < width_max && ledges[option->x_slot_hi].y_slot == option->y_slot_hi) {
+					width_hi = ledges[option->x_slot_hi].width;
+					ledges[option->x_slot_hi].width = 0;
+					width += width_hi;
+				}
+				if (x_slot && ledges[ledges[x_slot-1].x_slot_lo].y_slot == option->y_slot_hi) {
+					x_slot_lo = ledges[x_slot-1].x_slot_lo;
+					width_lo = ledges[x_slot_lo].width;
+					ledges[x_slot].width = 0;
+					width += width_lo;
+				}
+				set_ledge(x_slot_lo, width, option->y_slot_hi);
+				if (option->y_slot_hi < height_max) {
+					add_choice(option->y_slot_hi, x_slot);
+				}
+				if (option->slot_width < ledge_width) {
+					++choices_hi;
+					set_choice(choices_hi, y_slot, option->x_slot_hi);
+					insert_choice(choices_hi, choices_lo, choices_lo->next);
+				}
+				TELEMETRY(set_branches(PHASE_X, solutions_n));
+				r = search_x_slot(choices_lo->next);
+				TELEMETRY(close_branches(PHASE_X, solutions_n));
+				if (option->slot_width < ledge_width) {
+					link_choices(choices_hi->last, choices_hi->next);
+					--choices_hi;
+				}
+				if (option->y_slot_hi < height_max) {
+					link_choices(choices_hi->last, choices_hi->next);
+					--choices_hi;
+				}
+				if (width_lo) {
+					set_ledge(x_slot_lo, width_lo, option->y_slot_hi);
+				}
+				if (width_hi) {
+					set_ledge(option->x_slot_hi, width_hi, option->y_slot_hi);
+				}
+				else if (option->slot_width < ledge_width) {
+					ledges[option->x_slot_hi].width = 0;
+				}
+				set_ledge(x_slot, ledge_width, y_slot);
+				--solutions_n;
+				x_options ^= option->bit;
+				option->x_next->x_last = option;
+				option->x_last->x_next = option;
+				if (r) {
+					return r;
 				}
 			}
 		}
 		return 0;
 	}
 	print_solution();
+	if (count_flag) {
+		add_tiling();
+		return 0;
+	}
 	return 1;
 }
 
-static int is_valid_choice(const option_t *option, int y_slot, int x_slot) {
-	return option->y_slot_hi <= y_slot || option->x_slot_lo > x_slot || option->x_slot_hi <= x_slot;
+static option_t *get_x_option(option_t *option, int y_slot) {
+	if (masks_flag) {
+		unsigned long row = x_options & y_rows[y_slot] & ~get_low_mask(option != options_header ? (int)(option-options)+1:0);
+		return row ? options+get_low_bit(row):options_header;
+	}
+	for (option = option->x_next; option != options_header && option->y_slot_lo != y_slot; option = option->x_next);
+	return option;
 }
 
 static void add_choice(int y_slot, int x_slot) {
@@ -1026,39 +3846,184 @@ static void mp_print(const char *label, const int mp[]) {
 	flush_log(stdout, "\n");
 }
 
+static void set_stats(void) {
+	stats.tiles_n = 0UL;
+	stats.sets_n = 0UL;
+	stats.packs_n = 0UL;
+	stats.memos_n = 0UL;
+	stats.nogoods_n = 0UL;
+	stats.locks_n = 0UL;
+	stats.y_nodes_n = 0UL;
+	stats.x_nodes_n = 0UL;
+	stats.tiles_seconds = 0.0;
+	stats.sets_seconds = 0.0;
+	stats.packs_seconds = 0.0;
+	stats.y_seconds = 0.0;
+	stats.x_seconds = 0.0;
+}
+
+static void add_stats(const stats_t *level_stats) {
+	stats.tiles_n += level_stats->tiles_n;
+	stats.sets_n += level_stats->sets_n;
+	stats.packs_n += level_stats->packs_n;
+	stats.memos_n += level_stats->memos_n;
+	stats.nogoods_n += level_stats->nogoods_n;
+	stats.locks_n += level_stats->locks_n;
+	stats.y_nodes_n += level_stats->y_nodes_n;
+	stats.x_nodes_n += level_stats->x_nodes_n;
+	stats.tiles_seconds += level_stats->tiles_seconds;
+	stats.sets_seconds += level_stats->sets_seconds;
+	stats.packs_seconds += level_stats->packs_seconds;
+	stats.y_seconds += level_stats->y_seconds;
+	stats.x_seconds += level_stats->x_seconds;
+}
+
+static void print_stats(unsigned long nodes, double seconds) {
+	struct rusage usage;
+	printf("Stats sets enumerated %lu packed %lu memo %lu nogoods %lu\n", stats.sets_n, stats.packs_n, stats.memos_n, stats.nogoods_n);
+	printf("Stats tiles calls %lu seconds %.6f\n", stats.tiles_n, stats.tiles_seconds);
+	printf("Stats enumeration nodes %lu seconds %.6f\n", nodes-stats.y_nodes_n, stats.sets_seconds-stats.packs_seconds);
+	printf("Stats locking calls %lu locks %lu seconds %.6f\n", stats.packs_n, stats.locks_n, stats.packs_seconds-stats.y_seconds);
+	printf("Stats y nodes %lu seconds %.6f\n", stats.y_nodes_n-stats.x_nodes_n, stats.y_seconds-stats.x_seconds);
+	printf("Stats x nodes %lu seconds %.6f\n", stats.x_nodes_n, stats.x_seconds);
+	if (!getrusage(RUSAGE_SELF, &usage)) {
+		printf("Stats memory max_rss_kb %ld\n", usage.ru_maxrss);
+	}
+	flush_log(stdout, "Stats nodes %lu seconds %.6f nodes/s %.3e\n", nodes, seconds, seconds > 0.0 ? (double)nodes/seconds:0.0);
+}
+
+static void set_paint(paint_t *paint, int height, int width) {
+	paint->height = height;
+	paint->width = width;
+	paint->nodes = 0.0;
+	paint->seconds = 0.0;
+}
+
+static void set_place(place_t *place, int y_slot, int x_slot, int height, int width, int locked_flag) {
+	place->y_slot = y_slot;
+	place->x_slot = x_slot;
+	place->height = height;
+	place->width = width;
+	place->locked_flag = locked_flag;
+}
+
+static void set_prefix(prefix_t *prefix, int prefix_defect, int prefix_options, double nodes) {
+	prefix->defect = prefix_defect;
+	prefix->options = prefix_options;
+	prefix->unit = 0;
+	prefix->nodes = nodes;
+}
+
+static int compare_paints(const void *a, const void *b) {
+	const paint_t *paint_a = (const paint_t *)a, *paint_b = (const paint_t *)b;
+	if (paint_a->nodes < paint_b->nodes) {
+		return 1;
+	}
+	if (paint_a->nodes > paint_b->nodes) {
+		return -1;
+	}
+	if (paint_a->width != paint_b->width) {
+		return paint_a->width-paint_b->width;
+	}
+	return paint_a->height-paint_b->height;
+}
+
+static void set_record(record_t *record, const int *words) {
+	record->height = words[2];
+	record->width = words[3];
+	record->rotate_flag = words[4];
+	record->kind = words[5];
+	record->defect_lo = words[6];
+	record->defect_hi = words[7];
+	record->tiles_n = words[8];
+	record->tiles = words+RECORD_HEADER_SIZE;
+}
+
+static int compare_records(const void *a, const void *b) {
+	const record_t *record_a = (const record_t *)a, *record_b = (const record_t *)b;
+	if (record_a->height != record_b->height) {
+		return record_a->height-record_b->height;
+	}
+	if (record_a->width != record_b->width) {
+		return record_a->width-record_b->width;
+	}
+	if (record_a->rotate_flag != record_b->rotate_flag) {
+		return record_a->rotate_flag-record_b->rotate_flag;
+	}
+	if (record_a->kind != record_b->kind) {
+		return record_a->kind-record_b->kind;
+	}
+	return record_a->defect_lo-record_b->defect_lo;
+}
+
+static void set_symmetric_place(place_t *place, const place_t *source, int transform) {
+	if (transform & TRANSFORM_TRANSPOSE) {
+		set_place(place, source->x_slot, source->y_slot, source->width, source->height, 0);
+	}
+	else {
+		set_place(place, source->y_slot, source->x_slot, source->height, source->width, 0);
+	}
+	if (transform & TRANSFORM_FLIP_Y) {
+		place->y_slot = paint_height-place->y_slot-place->height;
+	}
+	if (transform & TRANSFORM_FLIP_X) {
+		place->x_slot = paint_width-place->x_slot-place->width;
+	}
+}
+
+static int compare_places(const void *a, const void *b) {
+	const place_t *place_a = (const place_t *)a, *place_b = (const place_t *)b;
+	if (place_a->y_slot != place_b->y_slot) {
+		return place_a->y_slot-place_b->y_slot;
+	}
+	return place_a->x_slot-place_b->x_slot;
+}
+
 static void set_tile(tile_t *tile, int height, int width) {
 	tile->height = height;
 	tile->width = width;
-	tile->area = height*width;
+	tile->area = (area_t)height*width;
 	tile->delta = width-height;
-	tile->slots_n = (paint_height-height+1)*(paint_width-width+1);
+	tile->nogood = -1;
+	tile->conflict = -1;
+	tile->slots_n = (unsigned long)(paint_height-height+1)*(unsigned long)(paint_width-width+1);
 	tile->rotate_flag = rotate_flag && tile->delta && width < paint_width && width <= paint_height;
 	if (tile->rotate_flag) {
-		tile->slots_n += (paint_height-width+1)*(paint_width-height+1);
+		tile->slots_n += (unsigned long)(paint_height-width+1)*(unsigned long)(paint_width-height+1);
 	}
 }
 
 static int compare_tiles(const void *a, const void *b) {
 	const tile_t *tile_a = (const tile_t *)a, *tile_b = (const tile_t *)b;
 	if (tile_a->area != tile_b->area) {
-		return tile_b->area-tile_a->area;
+		return tile_a->area < tile_b->area ? 1:-1;
 	}
 	if (tile_a->slots_n != tile_b->slots_n) {
-		return tile_b->slots_n-tile_a->slots_n;
+		return tile_a->slots_n < tile_b->slots_n ? 1:-1;
 	}
 	return tile_b->width-tile_a->width;
 }
 
+#ifdef MONDRIAN_LEAN
+static int compare_counts(const void *a, const void *b) {
+	const count_t *count_a = (const count_t *)a, *count_b = (const count_t *)b;
+	if (count_a->area != count_b->area) {
+		return count_a->area < count_b->area ? -1:1;
+	}
+	return 0;
+}
+
+#endif
 static void copy_tile(option_t *option, const tile_t *tile) {
 	option->height = tile->height;
 	option->width = tile->width;
 	option->area = tile->area;
-	option->slots_n = (height_max-tile->height+1)*(width_max-tile->width+1);
+	option->slots_n = (unsigned long)(height_max-tile->height+1)*(unsigned long)(width_max-tile->width+1);
 	option->rotate_flag = rotate_flag && tile->delta && tile->width <= height_max;
 	option->yh_slot_max = height_max-tile->height;
 	option->yw_slot_max = width_max-tile->width;
 	if (option->rotate_flag) {
-		option->slots_n += (height_max-tile->width+1)*(width_max-tile->height+1);
+		option->slots_n += (unsigned long)(height_max-tile->width+1)*(unsigned long)(width_max-tile->height+1);
 	}
 }
 
@@ -1071,10 +4036,10 @@ static void set_option(option_t *option) {
 static int compare_options(const void *a, const void *b) {
 	const option_t *option_a = (const option_t *)a, *option_b = (const option_t *)b;
 	if (option_a->slots_n != option_b->slots_n) {
-		return option_a->slots_n-option_b->slots_n;
+		return option_a->slots_n < option_b->slots_n ? -1:1;
 	}
 	if (option_a->area != option_b->area) {
-		return option_a->area-option_b->area;
+		return option_a->area < option_b->area ? -1:1;
 	}
 	return option_b->width-option_a->width;
 }
@@ -1109,6 +4074,82 @@ static void link_bars(bar_t *last, bar_t *next) {
 	next->last = last;
 }
 
+static void set_fits(void) {
+	int i, j;
+#ifdef MONDRIAN_LISTS
+	masks_flag = 0;
+#else
+	masks_flag = options_n <= OPTION_BITS;
+#endif
+	y_options = 0UL;
+	x_options = 0UL;
+	if (!masks_flag) {
+		for (i = 0; i < options_n; ++i) {
+			options[i].bit = 0UL;
+		}
+		return;
+	}
+	memset(width_fits, 0, sizeof(unsigned long)*(size_t)(width_max+1));
+	memset(height_fits, 0, sizeof(unsigned long)*(size_t)(width_max+1));
+	memset(yh_fits, 0, sizeof(unsigned long)*(size_t)height_max);
+	memset(yw_fits, 0, sizeof(unsigned long)*(size_t)height_max);
+	for (i = 0; i < options_n; ++i) {
+		option_t *option = options+i;
+		option->bit = 1UL << i;
+		y_options |= option->bit;
+		for (j = option->width; j <= width_max; ++j) {
+			width_fits[j] |= option->bit;
+		}
+		for (j = option->yh_slot_max; j >= 0; --j) {
+			yh_fits[j] |= option->bit;
+		}
+		if (option->rotate_flag) {
+			for (j = option->height; j <= width_max; ++j) {
+				height_fits[j] |= option->bit;
+			}
+			for (j = option->yw_slot_max; j >= 0; --j) {
+				yw_fits[j] |= option->bit;
+			}
+		}
+	}
+}
+
+static void set_rows(void) {
+	int i;
+	if (!masks_flag) {
+		return;
+	}
+	memset(y_rows, 0, sizeof(unsigned long)*(size_t)height_max);
+	for (i = 0; i < options_n; ++i) {
+		y_rows[options[i].y_slot_lo] |= options[i].bit;
+		x_options |= options[i].bit;
+	}
+}
+
+static unsigned long get_fits(int y_slot, int x_space) {
+	return (yh_fits[y_slot] & width_fits[x_space]) | (yw_fits[y_slot] & height_fits[x_space]);
+}
+
+static unsigned long get_low_mask(int bits_n) {
+	return bits_n < OPTION_BITS ? (1UL << bits_n)-1UL:~0UL;
+}
+
+static int get_low_bit(unsigned long bits) {
+#ifdef __GNUC__
+	return __builtin_ctzl(bits);
+#else
+	int bit;
+	for (bit = 0; !(bits & 1UL); bits >>= 1, ++bit);
+	return bit;
+#endif
+}
+
+static void set_ledge(int x_slot_lo, int width, int y_slot) {
+	ledges[x_slot_lo].y_slot = y_slot;
+	ledges[x_slot_lo].width = width;
+	ledges[x_slot_lo+width-1].x_slot_lo = x_slot_lo;
+}
+
 static void set_choice(choice_t *choice, int y_slot, int x_slot) {
 	choice->y_slot = y_slot;
 	choice->x_slot = x_slot;
@@ -1131,6 +4172,86 @@ static void link_choices(choice_t *last, choice_t *next) {
 	next->last = last;
 }
 
+static void set_budget(unsigned long nodes, int seconds) {
+	time_limit = seconds ? get_time()+seconds:0.0;
+	timeout_flag = 0;
+	set_nodes_limit(nodes);
+}
+
+static void set_nodes_limit(unsigned long nodes) {
+	nodes_limit = nodes ? nodes_n+nodes:ULONG_MAX;
+	nodes_max = time_limit > 0.0 && nodes_n+BUDGET_CHECK_NODES < nodes_limit ? nodes_n+BUDGET_CHECK_NODES:nodes_limit;
+}
+
+static int is_in_budget(void) {
+	if (timeout_flag || tilings_error) {
+		return 0;
+	}
+	if (nodes_n > nodes_limit || (time_limit > 0.0 && get_time() >= time_limit)) {
+		nodes_max = nodes_n;
+		timeout_flag = 1;
+		return 0;
+	}
+	nodes_max = nodes_n+BUDGET_CHECK_NODES < nodes_limit ? nodes_n+BUDGET_CHECK_NODES:nodes_limit;
+	return 1;
+}
+
+#ifdef MONDRIAN_TELEMETRY
+static void set_telemetry(void) {
+	int i;
+	for (i = PRUNES_N*depths_n; i--; ) {
+		prunes[i] = 0UL;
+	}
+	for (i = PHASES_N*depths_n*(BRANCHES_MAX+1); i--; ) {
+		histograms[i] = 0UL;
+	}
+}
+
+static void add_prune(int prune, int depth) {
+	++prunes[prune*depths_n+depth];
+}
+
+static void add_branch(int phase, int depth) {
+	++branches[phase*depths_n+depth];
+}
+
+static void set_branches(int phase, int depth) {
+	branches[phase*depths_n+depth] = 0;
+}
+
+static void close_branches(int phase, int depth) {
+	int branches_n = branches[phase*depths_n+depth];
+	++histograms[(phase*depths_n+depth)*(BRANCHES_MAX+1)+(branches_n < BRANCHES_MAX ? branches_n:BRANCHES_MAX)];
+}
+
+static void print_telemetry(void) {
+	int i, j, k;
+	for (i = 0; i < PRUNES_N; ++i) {
+		for (j = 0; j < depths_n; ++j) {
+			if (prunes[i*depths_n+j]) {
+				printf("Telemetry prune %s depth %d count %lu\n", prunes_names[i], j, prunes[i*depths_n+j]);
+			}
+		}
+	}
+	for (i = 0; i < PHASES_N; ++i) {
+		for (j = 0; j < depths_n; ++j) {
+			for (k = 0; k <= BRANCHES_MAX; ++k) {
+				if (histograms[(i*depths_n+j)*(BRANCHES_MAX+1)+k]) {
+					printf("Telemetry branch %s depth %d factor %d count %lu\n", phases_names[i], j, k, histograms[(i*depths_n+j)*(BRANCHES_MAX+1)+k]);
+				}
+			}
+		}
+	}
+	fflush(stdout);
+}
+#endif
+
+static double get_time(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec+(double)now.tv_nsec/1000000000.0;
+}
+
 static void flush_log(FILE *fd, const char *format, ...) {
 	va_list args;
 	va_start(args, format);
@@ -1139,8 +4260,188 @@ static void flush_log(FILE *fd, const char *format, ...) {
 	fflush(fd);
 }
 
+static int alloc_data(void) {
+	int choices_n;
+	tiles = malloc(sizeof(tile_t)*(size_t)(1+options_lo));
+	if (!tiles) {
+		flush_log(stderr, "Could not allocate memory for tiles\n");
+		return 0;
+	}
+	tiles_max = 1;
+	mondrian_tiles = malloc(sizeof(tile_t *)*(size_t)options_hi*3);
+	if (!mondrian_tiles) {
+		flush_log(stderr, "Could not allocate memory for mondrian_tiles\n");
+		free(tiles);
+		return 0;
+	}
+	cores = mondrian_tiles+options_hi;
+	options = malloc(sizeof(option_t)*(size_t)(options_hi+1));
+	if (!options) {
+		flush_log(stderr, "Could not allocate memory for options\n");
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+	solutions = malloc(sizeof(option_t *)*(size_t)options_hi);
+	if (!solutions) {
+		flush_log(stderr, "Could not allocate memory for solutions\n");
+		free(options);
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+	windows = malloc(sizeof(window_t)*(size_t)options_hi);
+	if (!windows) {
+		flush_log(stderr, "Could not allocate memory for windows\n");
+		free(solutions);
+		free(options);
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+	choices_n = options_hi*2;
+	choices = malloc(sizeof(choice_t)*(size_t)(choices_n+1));
+	if (!choices) {
+		flush_log(stderr, "Could not allocate memory for choices\n");
+		free(windows);
+		free(solutions);
+		free(options);
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+	choices_header = choices+choices_n;
+	set_choice(choices, 0, 0);
+	memo_ints = MEMO_KEY+options_hi*2;
+	memos_n = MEMO_INTS/memo_ints > 0 ? MEMO_INTS/memo_ints:1;
+	memos = calloc((size_t)memos_n*(size_t)memo_ints, sizeof(int));
+	if (!memos) {
+		flush_log(stderr, "Could not allocate memory for memos\n");
+		free(choices);
+		free(windows);
+		free(solutions);
+		free(options);
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+	if (json_flag || store_path || count_flag || pair_flag) {
+		places = malloc(sizeof(place_t)*(size_t)options_hi);
+		if (!places) {
+			flush_log(stderr, "Could not allocate memory for places\n");
+			free(memos);
+			free(choices);
+			free(windows);
+			free(solutions);
+			free(options);
+			free(mondrian_tiles);
+			free(tiles);
+			return 0;
+		}
+		places_max = options_hi;
+	}
+	if (count_flag) {
+		tiling_places = malloc(sizeof(place_t)*(size_t)options_hi);
+		if (!tiling_places) {
+			flush_log(stderr, "Could not allocate memory for tiling_places\n");
+			free(places);
+			free(memos);
+			free(choices);
+			free(windows);
+			free(solutions);
+			free(options);
+			free(mondrian_tiles);
+			free(tiles);
+			return 0;
+		}
+		tiling_words = malloc(sizeof(int)*(size_t)(options_hi*8+2));
+		if (!tiling_words) {
+			flush_log(stderr, "Could not allocate memory for tiling_words\n");
+			free(tiling_places);
+			free(places);
+			free(memos);
+			free(choices);
+			free(windows);
+			free(solutions);
+			free(options);
+			free(mondrian_tiles);
+			free(tiles);
+			return 0;
+		}
+	}
+#ifdef MONDRIAN_TELEMETRY
+	depths_n = options_hi+1;
+	prunes = malloc(sizeof(unsigned long)*(size_t)(PRUNES_N*depths_n));
+	if (!prunes) {
+		flush_log(stderr, "Could not allocate memory for prunes\n");
+		free(tiling_words);
+		free(tiling_places);
+		free(places);
+		free(memos);
+		free(choices);
+		free(windows);
+		free(solutions);
+		free(options);
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+	branches = malloc(sizeof(int)*(size_t)(PHASES_N*depths_n));
+	if (!branches) {
+		flush_log(stderr, "Could not allocate memory for branches\n");
+		free(prunes);
+		free(tiling_words);
+		free(tiling_places);
+		free(places);
+		free(memos);
+		free(choices);
+		free(windows);
+		free(solutions);
+		free(options);
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+	histograms = malloc(sizeof(unsigned long)*(size_t)(PHASES_N*depths_n*(BRANCHES_MAX+1)));
+	if (!histograms) {
+		flush_log(stderr, "Could not allocate memory for histograms\n");
+		free(branches);
+		free(prunes);
+		free(tiling_words);
+		free(tiling_places);
+		free(places);
+		free(memos);
+		free(choices);
+		free(windows);
+		free(solutions);
+		free(options);
+		free(mondrian_tiles);
+		free(tiles);
+		return 0;
+	}
+#endif
+	options_max = options_hi;
+	return 1;
+}
+
 static void free_data(void) {
+#ifdef MONDRIAN_TELEMETRY
+	free(histograms);
+	free(branches);
+	free(prunes);
+#endif
+	free(compat_areas);
+	free(compat_counts);
+	free(conflicts);
+	free(nogoods);
+	free(tilings_slots);
+	free(tilings_words);
+	free(tiling_words);
+	free(tiling_places);
+	free(places);
+	free(memos);
 	free(choices);
+	free(windows);
 	free(solutions);
 	free(options);
 	free(mondrian_tiles);
@@ -0,0 +1,74 @@
+#!/bin/bash
+if [ $# -lt 1 ] || [ $# -gt 2 ] || [ $1 -lt 1 ] || ([ $# -eq 2 ] && [ "$2" != "save" ])
+then
+	echo "Usage: $0 runs [save]"
+	exit 1
+fi
+make -f mondrian.make
+INSTANCES=mondrian_bench.txt
+BASELINE=mondrian_bench_baseline.txt
+THRESHOLD=10
+THRESHOLD_MS=10
+if [ $# -eq 2 ]
+then
+	rm -f $BASELINE.tmp
+fi
+FAILURES_N=0
+REGRESSIONS_N=0
+printf "%-32s %8s %8s %12s %12s %12s %10s %8s\n" name defect expected median_ms nodes nodes/s rss_kb change
+while read NAME REQUEST ORDER_LO ORDER_HI ROTATE_FLAG DEFECT_A DEFECT_B OPTIONS_LO OPTIONS_HI NODES EXPECTED
+do
+	OPTIONS="-s"
+	if [ $NODES -gt 0 ]
+	then
+		OPTIONS="$OPTIONS -n $NODES"
+	fi
+	TIMES=""
+	for RUN in $(seq 1 $1)
+	do
+		START=$(date +%s%N)
+		OUTPUT=$(echo $REQUEST $ORDER_LO $ORDER_HI $ROTATE_FLAG $DEFECT_A $DEFECT_B $OPTIONS_LO $OPTIONS_HI 0 | ./mondrian $OPTIONS)
+		END=$(date +%s%N)
+		TIMES="$TIMES $((END-START))"
+	done
+	MEDIAN=$(echo $TIMES | tr ' ' '\n' | sort -n | awk '{ t[NR] = $1 } END { printf "%.3f", (NR%2 ? t[(NR+1)/2] : (t[NR/2]+t[NR/2+1])/2)/1000000 }')
+	DEFECT=$(echo "$OUTPUT" | awk 'BEGIN { d = "none" } /^Defect/ { d = $2 } /^Timeout/ { d = "timeout" } END { print d }')
+	NODES_N=$(echo "$OUTPUT" | awk '/^Stats nodes/ { print $3 }')
+	RSS=$(echo "$OUTPUT" | awk '/^Stats memory/ { print $4 }')
+	RATE=$(awk -v n=$NODES_N -v t=$MEDIAN 'BEGIN { printf "%.3e", (t > 0 ? n*1000/t : 0) }')
+	CHANGE="-"
+	if [ -f $BASELINE ]
+	then
+		BASE=$(awk -v name=$NAME '$1 == name { print $2 }' $BASELINE)
+		if [ -n "$BASE" ]
+		then
+			CHANGE=$(awk -v b=$BASE -v t=$MEDIAN 'BEGIN { printf "%+.1f%%", (b > 0 ? (t-b)*100/b : 0) }')
+			if awk -v b=$BASE -v t=$MEDIAN -v p=$THRESHOLD -v m=$THRESHOLD_MS 'BEGIN { exit !(t > b*(100+p)/100 && t > b+m) }'
+			then
+				CHANGE="$CHANGE REGRESSION"
+				REGRESSIONS_N=$((REGRESSIONS_N+1))
+			fi
+		fi
+	fi
+	if [ "$DEFECT" != "$EXPECTED" ]
+	then
+		CHANGE="$CHANGE MISMATCH"
+		FAILURES_N=$((FAILURES_N+1))
+	fi
+	printf "%-32s %8s %8s %12s %12s %12s %10s %8s\n" $NAME $DEFECT $EXPECTED $MEDIAN $NODES_N $RATE $RSS "$CHANGE"
+	if [ $# -eq 2 ]
+	then
+		echo $NAME $MEDIAN >>$BASELINE.tmp
+	fi
+done <$INSTANCES
+if [ $# -eq 2 ]
+then
+	mv $BASELINE.tmp $BASELINE
+	echo "Baseline saved to $BASELINE"
+fi
+echo "Mismatches $FAILURES_N regressions $REGRESSIONS_N (threshold $THRESHOLD% and $THRESHOLD_MS ms)"
+if [ $FAILURES_N -gt 0 ] || [ $REGRESSIONS_N -gt 0 ]
+then
+	exit 1
+fi
+exit 0
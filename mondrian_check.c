@@ -0,0 +1,589 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define LINE_SIZE 65536
+#define TILES_MIN 2U
+#define SIZE_T_MAX (size_t)-1
+#define WORD_BITS (sizeof(unsigned long)*CHAR_BIT)
+
+typedef struct {
+	unsigned y0;
+	unsigned x0;
+	unsigned y1;
+	unsigned x1;
+}
+tile_t;
+
+typedef struct {
+	unsigned height;
+	unsigned width;
+}
+shape_t;
+
+static int read_option(int, char *[], int *, long, long, long *);
+static int run_workers(const char *, unsigned long *, unsigned long *);
+static int check_file(const char *, int, unsigned long *, unsigned long *);
+static int read_line(FILE *);
+static int grow_line(void);
+static int read_solution(FILE *, unsigned, unsigned, unsigned, int *);
+static int place_locks(unsigned, unsigned, unsigned);
+static int set_locks(unsigned, unsigned, unsigned, unsigned, unsigned);
+static int read_view(FILE *, unsigned);
+static int is_symbol(size_t, size_t, size_t);
+static int reserve_tiles(unsigned);
+static int add_tile(unsigned, unsigned, unsigned, unsigned);
+static int check_tiling(int, int);
+static int compare_shapes(const void *, const void *);
+static int fail_tiling(const char *, ...);
+static void free_data(void);
+
+static char *line, *cells;
+static int rotate_flag = 1, workers_n = 1, own_flag, line_error_flag;
+static unsigned paint_height, paint_width, tiles_n, tiles_max;
+static unsigned long lines_n, solution_line, *words;
+static size_t line_max, words_max, cells_max;
+static const char *check_path;
+static tile_t *tiles;
+static shape_t *shapes;
+
+int main(int argc, char *argv[]) {
+	int failed_flag = 0, r = 1, i;
+	for (i = 1; i < argc && argv[i][0] == '-' && r; ++i) {
+		long value;
+		if (!strcmp(argv[i], "-r")) {
+			r = read_option(argc, argv, &i, 0L, 1L, &value);
+			rotate_flag = (int)value;
+		}
+		else if (!strcmp(argv[i], "-w")) {
+			r = read_option(argc, argv, &i, 1L, (long)INT_MAX, &value);
+			workers_n = (int)value;
+		}
+		else {
+			r = 0;
+		}
+	}
+	if (!r || i == argc) {
+		fputs("Expected parameters: [ -r rotate_flag (0 or 1) ] [ -w workers_n (>= 1) ] path [ path ... ]\n", stderr);
+		fflush(stderr);
+		return EXIT_FAILURE;
+	}
+	for (; i < argc && r; ++i) {
+		unsigned long solutions_n = 0UL, failures_n = 0UL;
+		r = workers_n > 1 ? run_workers(argv[i], &solutions_n, &failures_n):check_file(argv[i], 0, &solutions_n, &failures_n);
+		if (r) {
+			printf("File %s solutions %lu passed %lu failed %lu\n", argv[i], solutions_n, solutions_n-failures_n, failures_n);
+			fflush(stdout);
+			if (failures_n) {
+				failed_flag = 1;
+			}
+		}
+	}
+	free_data();
+	return r && !failed_flag ? EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+static int read_option(int argc, char *argv[], int *i, long value_min, long value_max, long *value) {
+	char *end;
+	++*i;
+	if (*i == argc) {
+		return 0;
+	}
+	*value = strtol(argv[*i], &end, 10);
+	return !*end && end != argv[*i] && *value >= value_min && *value <= value_max;
+}
+
+static int run_workers(const char *path, unsigned long *solutions_n, unsigned long *failures_n) {
+	int r = 1, workers_hi;
+	int *fds = malloc(sizeof(int)*(size_t)workers_n);
+	pid_t *pids;
+	if (!fds) {
+		fputs("Could not allocate memory for fds\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	pids = malloc(sizeof(pid_t)*(size_t)workers_n);
+	if (!pids) {
+		fputs("Could not allocate memory for pids\n", stderr);
+		fflush(stderr);
+		free(fds);
+		return 0;
+	}
+	fflush(stdout);
+	for (workers_hi = 0; workers_hi < workers_n; ++workers_hi) {
+		int pipe_fds[2];
+		if (pipe(pipe_fds)) {
+			fputs("Could not create pipe\n", stderr);
+			fflush(stderr);
+			r = 0;
+			break;
+		}
+		pids[workers_hi] = fork();
+		if (!pids[workers_hi]) {
+			unsigned long counts[2] = { 0UL, 0UL };
+			int worker_r;
+			close(pipe_fds[0]);
+			worker_r = check_file(path, workers_hi, counts, counts+1);
+			fflush(stdout);
+			if (worker_r && write(pipe_fds[1], counts, sizeof(counts)) != (ssize_t)sizeof(counts)) {
+				worker_r = 0;
+			}
+			_exit(worker_r ? EXIT_SUCCESS:EXIT_FAILURE);
+		}
+		close(pipe_fds[1]);
+		if (pids[workers_hi] < 0) {
+			fputs("Could not start worker\n", stderr);
+			fflush(stderr);
+			close(pipe_fds[0]);
+			r = 0;
+			break;
+		}
+		fds[workers_hi] = pipe_fds[0];
+	}
+	while (workers_hi--) {
+		unsigned long counts[2];
+		int status;
+		if (read(fds[workers_hi], counts, sizeof(counts)) == (ssize_t)sizeof(counts)) {
+			*solutions_n += counts[0];
+			*failures_n += counts[1];
+		}
+		else {
+			r = 0;
+		}
+		close(fds[workers_hi]);
+		if (waitpid(pids[workers_hi], &status, 0) != pids[workers_hi] || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+			r = 0;
+		}
+	}
+	free(pids);
+	free(fds);
+	return r;
+}
+
+static int check_file(const char *path, int worker_idx, unsigned long *solutions_n, unsigned long *failures_n) {
+	int rotate_file_flag = rotate_flag, tiling_defect = -1, line_flag, r = 1;
+	unsigned order = 0U, stream_height = 0U, stream_width = 0U;
+	unsigned long solutions_idx = 0UL;
+	FILE *fd = fopen(path, "r");
+	if (!fd) {
+		fprintf(stderr, "Could not open %s\n", path);
+		fflush(stderr);
+		return 0;
+	}
+	check_path = path;
+	lines_n = 0UL;
+	line_error_flag = 0;
+	line_flag = read_line(fd);
+	while (line_flag && r) {
+		unsigned y0, x0, height, width, options_n;
+		int solution_flag = 0, defect;
+		solution_line = lines_n;
+		own_flag = solutions_idx%(unsigned long)workers_n == (unsigned long)worker_idx;
+		if (sscanf(line, "%ux%u;%ux%u", &y0, &x0, &height, &width) == 4) {
+			tiles_n = 0U;
+			r = reserve_tiles(order);
+			while (r) {
+				r = add_tile(y0, x0, height, width);
+				line_flag = read_line(fd);
+				if (!line_flag || sscanf(line, "%ux%u;%ux%u", &y0, &x0, &height, &width) != 4) {
+					break;
+				}
+			}
+			if (r && order && tiling_defect >= 0) {
+				solution_flag = 1;
+				if (own_flag) {
+					paint_height = order;
+					paint_width = order;
+					r = check_tiling(rotate_file_flag, tiling_defect);
+				}
+			}
+			tiling_defect = -1;
+		}
+		else {
+			if (strstr(line, "ROTATE FLAG ON")) {
+				rotate_file_flag = 1;
+			}
+			else if (strstr(line, "ROTATE FLAG OFF")) {
+				rotate_file_flag = 0;
+			}
+			else if (sscanf(line, "SQUARE ORDER %u", &order) == 1) {
+				tiling_defect = -1;
+			}
+			else if (!strncmp(line, "SQUARES", strlen("SQUARES")) || !strncmp(line, "RECTANGLES", strlen("RECTANGLES"))) {
+				order = 0U;
+				tiling_defect = -1;
+			}
+			else if (sscanf(line, "Optimal %d", &defect) == 1 || sscanf(line, "Upper bound %d", &defect) == 1) {
+				tiling_defect = defect;
+			}
+			else if (sscanf(line, "Square %ux%u", &height, &width) == 2 || sscanf(line, "Rectangle %ux%u", &height, &width) == 2 || sscanf(line, "Unique %ux%u", &height, &width) == 2) {
+				stream_height = height;
+				stream_width = width;
+			}
+			else if (sscanf(line, "0 %u %u %u", &height, &width, &options_n) == 3) {
+				solution_flag = 1;
+				paint_height = stream_height ? stream_height:height;
+				paint_width = stream_height ? stream_width:width;
+				r = read_solution(fd, height, width, options_n, &defect);
+				if (r > 0 && own_flag) {
+					r = check_tiling(rotate_file_flag, defect);
+				}
+			}
+			else if (sscanf(line, "a(%u)=%d", &order, &defect) == 2) {
+				solution_flag = 1;
+				paint_height = order;
+				paint_width = order;
+				r = read_view(fd, order);
+				if (r > 0 && own_flag) {
+					r = check_tiling(rotate_file_flag, defect);
+				}
+				order = 0U;
+			}
+			line_flag = read_line(fd);
+		}
+		if (solution_flag) {
+			if (own_flag) {
+				++*solutions_n;
+				if (r < 0) {
+					++*failures_n;
+				}
+			}
+			if (r < 0) {
+				r = 1;
+			}
+			++solutions_idx;
+		}
+	}
+	fclose(fd);
+	return r && !line_error_flag;
+}
+
+static int read_line(FILE *fd) {
+	size_t len;
+	if (!line && !grow_line()) {
+		return 0;
+	}
+	if (!fgets(line, (int)line_max, fd)) {
+		return 0;
+	}
+	len = strlen(line);
+	while (len == line_max-1 && line[len-1] != '\n') {
+		if (!grow_line()) {
+			return 0;
+		}
+		if (!fgets(line+len, (int)(line_max-len), fd)) {
+			break;
+		}
+		len += strlen(line+len);
+	}
+	++lines_n;
+	return 1;
+}
+
+static int grow_line(void) {
+	size_t line_max_tmp = line_max ? line_max*2:LINE_SIZE;
+	char *line_tmp;
+	if (line_max_tmp > INT_MAX) {
+		fprintf(stderr, "Line %lu of %s is too long\n", lines_n+1UL, check_path);
+		fflush(stderr);
+		line_error_flag = 1;
+		return 0;
+	}
+	line_tmp = realloc(line, line_max_tmp);
+	if (!line_tmp) {
+		fputs("Could not reallocate memory for line\n", stderr);
+		fflush(stderr);
+		line_error_flag = 1;
+		return 0;
+	}
+	line = line_tmp;
+	line_max = line_max_tmp;
+	return 1;
+}
+
+static int read_solution(FILE *fd, unsigned height_max, unsigned width_max, unsigned options_n, int *defect) {
+	unsigned y0, x0, height, width, tile_idx;
+	if (!own_flag) {
+		for (tile_idx = 0U; tile_idx < options_n && read_line(fd); ++tile_idx);
+		while (read_line(fd) && strncmp(line, "Defect", strlen("Defect")));
+		return 1;
+	}
+	tiles_n = 0U;
+	if (!reserve_tiles(paint_height > paint_width ? paint_height:paint_width)) {
+		return 0;
+	}
+	for (tile_idx = 0U; tile_idx < options_n; ++tile_idx) {
+		if (!read_line(fd) || sscanf(line, "%ux%u;%ux%u", &y0, &x0, &height, &width) != 4) {
+			return fail_tiling("invalid tile");
+		}
+		if (!add_tile(y0, x0, height, width)) {
+			return 0;
+		}
+	}
+	if (!read_line(fd)) {
+		return fail_tiling("missing Defect line");
+	}
+	if (!strcmp(line, "Locks\n")) {
+		while (read_line(fd) && sscanf(line, "%ux%u", &height, &width) == 2) {
+			if (!add_tile(0U, 0U, height, width)) {
+				return 0;
+			}
+		}
+	}
+	if (sscanf(line, "Defect %d", defect) != 1) {
+		return fail_tiling("missing Defect line");
+	}
+	if (!paint_height || !paint_width) {
+		return fail_tiling("invalid paint");
+	}
+	if (!place_locks(options_n, height_max, width_max)) {
+		return fail_tiling("locks do not fit in paint");
+	}
+	return 1;
+}
+
+#include "mondrian_locks.h"
+
+static int read_view(FILE *fd, unsigned order) {
+	unsigned y, x;
+	size_t row_len = 0, symbol_len;
+	for (y = 0U; y < order; ++y) {
+		size_t len;
+		if (!read_line(fd)) {
+			return fail_tiling("missing row");
+		}
+		len = strcspn(line, "\r\n");
+		if (!y) {
+			row_len = len;
+			if (!row_len || row_len%order) {
+				return fail_tiling("invalid row");
+			}
+			if (own_flag && row_len*order > cells_max) {
+				char *cells_tmp;
+				if (row_len > SIZE_T_MAX/order) {
+					return fail_tiling("paint too large");
+				}
+				cells_tmp = realloc(cells, row_len*order);
+				if (!cells_tmp) {
+					fputs("Could not reallocate memory for cells\n", stderr);
+					fflush(stderr);
+					return 0;
+				}
+				cells = cells_tmp;
+				cells_max = row_len*order;
+			}
+		}
+		if (len != row_len) {
+			return fail_tiling("invalid row");
+		}
+		if (own_flag) {
+			memcpy(cells+y*row_len, line, row_len);
+		}
+	}
+	if (!own_flag || !order) {
+		return 1;
+	}
+	symbol_len = row_len/order;
+	tiles_n = 0U;
+	if (!reserve_tiles(order)) {
+		return 0;
+	}
+	for (y = 0U; y < order; ++y) {
+		for (x = 0U; x < order; ++x) {
+			size_t cell = (y*order+x)*symbol_len;
+			if (cells[cell]) {
+				unsigned height, width, y_ring, x_ring;
+				for (width = 1U; x+width < order && is_symbol(cell, cell+width*symbol_len, symbol_len); ++width);
+				for (height = 1U; y+height < order; ++height) {
+					for (x_ring = 0U; x_ring < width && is_symbol(cell, cell+(height*order+x_ring)*symbol_len, symbol_len); ++x_ring);
+					if (x_ring < width) {
+						break;
+					}
+				}
+				for (y_ring = y ? y-1U:y; y_ring <= y+height && y_ring < order; ++y_ring) {
+					for (x_ring = x ? x-1U:x; x_ring <= x+width && x_ring < order; ++x_ring) {
+						if ((y_ring < y || y_ring == y+height || x_ring < x || x_ring == x+width) && is_symbol(cell, (y_ring*order+x_ring)*symbol_len, symbol_len)) {
+							return fail_tiling("symbol at %ux%u is not a rectangle", y, x);
+						}
+					}
+				}
+				for (y_ring = y; y_ring < y+height; ++y_ring) {
+					memset(cells+(y_ring*order+x)*symbol_len, 0, width*symbol_len);
+				}
+				if (!add_tile(y, x, height, width)) {
+					return 0;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+static int is_symbol(size_t cell_a, size_t cell_b, size_t symbol_len) {
+	return !memcmp(cells+cell_a, cells+cell_b, symbol_len);
+}
+
+static int reserve_tiles(unsigned tiles_min) {
+	unsigned tiles_max_tmp = tiles_max ? tiles_max:TILES_MIN;
+	tile_t *tiles_tmp;
+	shape_t *shapes_tmp;
+	if (tiles_max >= tiles_min) {
+		return 1;
+	}
+	while (tiles_max_tmp < tiles_min) {
+		if (tiles_max_tmp > UINT_MAX/2U) {
+			fputs("Too many tiles\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		tiles_max_tmp *= 2U;
+	}
+	tiles_tmp = realloc(tiles, sizeof(tile_t)*(size_t)tiles_max_tmp);
+	if (!tiles_tmp) {
+		fputs("Could not reallocate memory for tiles\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	tiles = tiles_tmp;
+	shapes_tmp = realloc(shapes, sizeof(shape_t)*(size_t)tiles_max_tmp);
+	if (!shapes_tmp) {
+		fputs("Could not reallocate memory for shapes\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	shapes = shapes_tmp;
+	tiles_max = tiles_max_tmp;
+	return 1;
+}
+
+static int add_tile(unsigned y0, unsigned x0, unsigned height, unsigned width) {
+	if (tiles_n == tiles_max && !reserve_tiles(tiles_n+1U)) {
+		return 0;
+	}
+	tiles[tiles_n].y0 = y0;
+	tiles[tiles_n].x0 = x0;
+	tiles[tiles_n].y1 = y0+height;
+	tiles[tiles_n].x1 = x0+width;
+	++tiles_n;
+	return 1;
+}
+
+static int check_tiling(int rotate_tiling_flag, int defect) {
+	unsigned long area_sum = 0UL, area_min = ULONG_MAX, area_max = 0UL;
+	unsigned tile_idx;
+	size_t row_words;
+	if (!paint_height || !paint_width) {
+		return fail_tiling("invalid paint");
+	}
+	row_words = (paint_width-1U)/WORD_BITS+1U;
+	if (row_words > SIZE_T_MAX/sizeof(unsigned long)/paint_height) {
+		return fail_tiling("paint too large");
+	}
+	if (row_words*paint_height > words_max) {
+		unsigned long *words_tmp = realloc(words, sizeof(unsigned long)*row_words*paint_height);
+		if (!words_tmp) {
+			fputs("Could not reallocate memory for words\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		words = words_tmp;
+		words_max = row_words*paint_height;
+	}
+	memset(words, 0, sizeof(unsigned long)*row_words*paint_height);
+	for (tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		const tile_t *tile = tiles+tile_idx;
+		unsigned long area;
+		size_t word_lo, word_hi;
+		unsigned y;
+		if (tile->y0 >= tile->y1 || tile->y1 > paint_height || tile->x0 >= tile->x1 || tile->x1 > paint_width) {
+			return fail_tiling("tile %ux%u;%ux%u out of paint", tile->y0, tile->x0, tile->y1-tile->y0, tile->x1-tile->x0);
+		}
+		word_lo = tile->x0/WORD_BITS;
+		word_hi = (tile->x1-1U)/WORD_BITS;
+		for (y = tile->y0; y < tile->y1; ++y) {
+			size_t word_idx;
+			for (word_idx = word_lo; word_idx <= word_hi; ++word_idx) {
+				unsigned long mask = ~0UL, *word = words+y*row_words+word_idx;
+				if (word_idx == word_lo) {
+					mask &= ~0UL << tile->x0%WORD_BITS;
+				}
+				if (word_idx == word_hi) {
+					mask &= ~0UL >> (WORD_BITS-1U-(tile->x1-1U)%WORD_BITS);
+				}
+				if (*word & mask) {
+					size_t bit;
+					for (bit = 0U; !(*word & mask & 1UL << bit); ++bit);
+					return fail_tiling("overlap at %ux%lu", y, (unsigned long)(word_idx*WORD_BITS+bit));
+				}
+				*word |= mask;
+			}
+		}
+		area = (unsigned long)(tile->y1-tile->y0)*(tile->x1-tile->x0);
+		if (area < area_min) {
+			area_min = area;
+		}
+		if (area > area_max) {
+			area_max = area;
+		}
+		area_sum += area;
+		if (rotate_tiling_flag && tile->y1-tile->y0 > tile->x1-tile->x0) {
+			shapes[tile_idx].height = tile->x1-tile->x0;
+			shapes[tile_idx].width = tile->y1-tile->y0;
+		}
+		else {
+			shapes[tile_idx].height = tile->y1-tile->y0;
+			shapes[tile_idx].width = tile->x1-tile->x0;
+		}
+	}
+	if (area_sum != (unsigned long)paint_height*paint_width) {
+		return fail_tiling("paint not fully covered");
+	}
+	qsort(shapes, (size_t)tiles_n, sizeof(shape_t), compare_shapes);
+	for (tile_idx = 1U; tile_idx < tiles_n && compare_shapes(shapes+tile_idx-1, shapes+tile_idx); ++tile_idx);
+	if (tile_idx < tiles_n) {
+		return fail_tiling("duplicate tile %ux%u", shapes[tile_idx].height, shapes[tile_idx].width);
+	}
+	if (defect < 0 || area_max-area_min != (unsigned long)defect) {
+		return fail_tiling("defect %lu instead of %d", area_max-area_min, defect);
+	}
+	return 1;
+}
+
+static int compare_shapes(const void *a, const void *b) {
+	const shape_t *shape_a = (const shape_t *)a, *shape_b = (const shape_t *)b;
+	if (shape_a->height != shape_b->height) {
+		return shape_a->height < shape_b->height ? -1:1;
+	}
+	if (shape_a->width != shape_b->width) {
+		return shape_a->width < shape_b->width ? -1:1;
+	}
+	return 0;
+}
+
+static int fail_tiling(const char *format, ...) {
+	va_list args;
+	if (own_flag) {
+		printf("Failed %s line %lu: ", check_path, solution_line);
+		va_start(args, format);
+		vprintf(format, args);
+		va_end(args);
+		puts("");
+		fflush(stdout);
+	}
+	return -1;
+}
+
+static void free_data(void) {
+	free(shapes);
+	free(tiles);
+	free(cells);
+	free(words);
+	free(line);
+}
@@ -0,0 +1,34 @@
+#!/bin/bash
+if [ $# -ne 0 ]
+then
+	echo "Usage: $0"
+	exit 1
+fi
+make -f mondrian.make
+make -f mondrian_lists.make
+INSTANCES=mondrian_bench.txt
+FAILURES_N=0
+printf "%-32s %12s %12s %12s %8s\n" name nodes y_nodes x_nodes change
+while read NAME REQUEST ORDER_LO ORDER_HI ROTATE_FLAG DEFECT_A DEFECT_B OPTIONS_LO OPTIONS_HI NODES EXPECTED
+do
+	OPTIONS="-s"
+	if [ $NODES -gt 0 ]
+	then
+		OPTIONS="$OPTIONS -n $NODES"
+	fi
+	MASKS=$(echo $REQUEST $ORDER_LO $ORDER_HI $ROTATE_FLAG $DEFECT_A $DEFECT_B $OPTIONS_LO $OPTIONS_HI 0 | ./mondrian $OPTIONS | awk '/^Stats nodes/ { n = $3 } /^Stats y nodes/ { y += $4 } /^Stats x nodes/ { x += $4 } END { print n, y, x }')
+	LISTS=$(echo $REQUEST $ORDER_LO $ORDER_HI $ROTATE_FLAG $DEFECT_A $DEFECT_B $OPTIONS_LO $OPTIONS_HI 0 | ./mondrian_lists $OPTIONS | awk '/^Stats nodes/ { n = $3 } /^Stats y nodes/ { y += $4 } /^Stats x nodes/ { x += $4 } END { print n, y, x }')
+	CHANGE="-"
+	if [ "$MASKS" != "$LISTS" ]
+	then
+		CHANGE="MISMATCH $LISTS"
+		FAILURES_N=$((FAILURES_N+1))
+	fi
+	printf "%-32s %12s %12s %12s %8s\n" $NAME $MASKS "$CHANGE"
+done <$INSTANCES
+echo "Mismatches $FAILURES_N"
+if [ $FAILURES_N -gt 0 ]
+then
+	exit 1
+fi
+exit 0
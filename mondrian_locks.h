@@ -0,0 +1,48 @@
+static int place_locks(unsigned locks_lo, unsigned height_max, unsigned width_max) {
+	unsigned tile_idx;
+	if (set_locks(locks_lo, paint_height, paint_width, height_max, width_max)) {
+		return 1;
+	}
+	for (tile_idx = locks_lo; tile_idx < tiles_n; ++tile_idx) {
+		tiles[tile_idx].y1 -= tiles[tile_idx].y0;
+		tiles[tile_idx].x1 -= tiles[tile_idx].x0;
+		tiles[tile_idx].y0 = 0U;
+		tiles[tile_idx].x0 = 0U;
+	}
+	if (paint_height == paint_width || !set_locks(locks_lo, paint_width, paint_height, height_max, width_max)) {
+		return 0;
+	}
+	for (tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		tile_t tile = tiles[tile_idx];
+		tiles[tile_idx].y0 = tile.x0;
+		tiles[tile_idx].x0 = tile.y0;
+		tiles[tile_idx].y1 = tile.x1;
+		tiles[tile_idx].x1 = tile.y1;
+	}
+	return 1;
+}
+
+static int set_locks(unsigned locks_lo, unsigned height, unsigned width, unsigned height_max, unsigned width_max) {
+	unsigned locks_hi, tile_idx;
+	for (locks_hi = locks_lo; locks_hi < tiles_n; ++locks_hi) {
+		tile_t tile;
+		for (tile_idx = locks_hi; tile_idx < tiles_n && (tiles[tile_idx].y1 != height || tiles[tile_idx].x1 > width) && (tiles[tile_idx].x1 != width || tiles[tile_idx].y1 > height); ++tile_idx);
+		if (tile_idx == tiles_n) {
+			return 0;
+		}
+		tile = tiles[tile_idx];
+		tiles[tile_idx] = tiles[locks_hi];
+		if (tile.y1 == height) {
+			width -= tile.x1;
+			tile.x0 = width;
+		}
+		else {
+			height -= tile.y1;
+			tile.y0 = height;
+		}
+		tile.y1 += tile.y0;
+		tile.x1 += tile.x0;
+		tiles[locks_hi] = tile;
+	}
+	return (height == height_max && width == width_max) || ((!height || !width) && (!height_max || !width_max));
+}
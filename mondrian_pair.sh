@@ -0,0 +1,19 @@
+#!/bin/bash
+if [ $# -ne 0 ]
+then
+	echo "Usage: $0"
+	exit 1
+fi
+make -f mondrian.make
+STORE=$(mktemp)
+rm -f $STORE
+echo 3 11 11 1 20 0 2 40 0 | ./mondrian -R $STORE >/dev/null
+OUTPUT=$(echo 3 11 11 1 20 0 2 4 0 | ./mondrian -B -R $STORE)
+rm -f $STORE
+RESULT=$(echo "$OUTPUT" | awk '/^Rotate/ { r = $2 } /^Pair upper bound/ { b = $4 } /^0 / { n = $4 } /^Defect/ && r == 0 { d = $2 } END { print b, n, d }')
+echo "Pair upper bound, tiles and defect of the run with rotate flag off: $RESULT (expected 6 8 6)"
+if [ "$RESULT" != "6 8 6" ]
+then
+	exit 1
+fi
+exit 0
@@ -1,10 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define PAINT_WIDTH_MIN 3U
 #define SIZE_T_MAX (size_t)-1
 #define TILES_MIN 2U
-#define TILES_MAX 52U
+#define SYMBOLS_N 52U
+#define EDGES_MIN 1024U
+#define NODES_MAX 1000000UL
+#define LINE_SIZE 256
 
 typedef struct tile_s tile_t;
 
@@ -15,117 +19,383 @@ struct tile_s {
 	unsigned x1;
 	unsigned neighbours_n;
 	tile_t **neighbours;
-	int symbol;
+	unsigned colour;
+	unsigned saturation;
+	unsigned *colours_n;
 };
 
+static int read_stream(int);
+static int read_solution(unsigned, unsigned, unsigned, int);
+static int place_locks(unsigned, unsigned, unsigned);
+static int set_locks(unsigned, unsigned, unsigned, unsigned, unsigned);
+static int alloc_tiles(unsigned);
+static int alloc_paint(unsigned);
+static int view_tiling(int);
+static void free_data(void);
 static void set_tile(tile_t *, unsigned, unsigned, unsigned, unsigned);
+static int set_neighbours(void);
+static int compare_tiles(const void *, const void *);
+static int add_edge(unsigned, unsigned);
 static int are_neighbours(const tile_t *, const tile_t *);
-static void try_symbol(unsigned, unsigned);
-static void set_symbol(tile_t *, int);
-static void print_paint(void);
+static int set_colours(void);
+static void set_colours_lo(void);
+static void try_colour(unsigned, unsigned);
+static tile_t *get_tile_max(void);
+static void set_colour(tile_t *, unsigned);
+static void unset_colour(tile_t *);
+static void print_paint(const unsigned *, unsigned);
 
-static int symbols[TILES_MAX] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z' }, *paint;
-static unsigned paint_height, paint_width, tiles_n, symbols_max;
-static tile_t *tiles, **neighbours_cur;
+static int symbols[SYMBOLS_N] = { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z' };
+static char line[LINE_SIZE];
+static unsigned paint_height, paint_width, paint_max, row_max, tiles_n, tiles_max, edges_n, edges_max, neighbours_max, colours_n_max, colours_max, colours_lo, colours_best, *row, *edges, *colours_n, *colours_best_tiles, *tiles_symbols;
+static unsigned char *paint;
+static unsigned long nodes_n;
+static tile_t *tiles, **tiles_sorted, **tiles_active, **neighbours;
 
-int main(void) {
+int main(int argc, char *argv[]) {
 	int minimize_flag;
-	unsigned paint_area, tiles_area_sum, tile_idx;
-	tile_t **neighbours;
-	if (scanf("%d%u%u%u", &minimize_flag, &paint_height, &paint_width, &tiles_n) != 4 || paint_height < 1 || paint_width < PAINT_WIDTH_MIN || paint_height > paint_width || paint_height > SIZE_T_MAX/paint_width || tiles_n < TILES_MIN || tiles_n > TILES_MAX) {
-		fprintf(stderr, "Expected parameters: minimize_flag, paint_height (>= 1), paint_width (>= %u and >= paint_height), tiles_n (>= %u).\n", PAINT_WIDTH_MIN, TILES_MIN);
+	unsigned tile_idx;
+	if (argc == 3 && !strcmp(argv[1], "-s")) {
+		char *end;
+		minimize_flag = (int)strtol(argv[2], &end, 10);
+		if (*end || end == argv[2]) {
+			fputs("Expected minimize_flag after option -s\n", stderr);
+			fflush(stderr);
+			return EXIT_FAILURE;
+		}
+		if (!read_stream(minimize_flag)) {
+			free_data();
+			return EXIT_FAILURE;
+		}
+		free_data();
+		return EXIT_SUCCESS;
+	}
+	if (argc > 1) {
+		fputs("Usage: mondrian_view [ -s minimize_flag ]\n", stderr);
 		fflush(stderr);
 		return EXIT_FAILURE;
 	}
-	paint_area = paint_height*paint_width;
-	if (sizeof(int) > SIZE_T_MAX/paint_area) {
-		fputs("Will not be able to allocate memory for paint\n", stderr);
+	if (scanf("%d%u%u%u", &minimize_flag, &paint_height, &paint_width, &tiles_n) != 4 || paint_height < 1 || paint_width < PAINT_WIDTH_MIN || paint_height > paint_width || paint_height > SIZE_T_MAX/paint_width || tiles_n < TILES_MIN) {
+		fprintf(stderr, "Expected parameters: minimize_flag, paint_height (>= 1), paint_width (>= %u and >= paint_height), tiles_n (>= %u).\n", PAINT_WIDTH_MIN, TILES_MIN);
 		fflush(stderr);
 		return EXIT_FAILURE;
 	}
-	paint = calloc((size_t)paint_area, sizeof(int));
-	if (!paint) {
-		fputs("Could not allocate memory for paint\n", stderr);
-		fflush(stderr);
+	if (!alloc_tiles(tiles_n)) {
+		free_data();
 		return EXIT_FAILURE;
 	}
-	tiles = malloc(sizeof(tile_t)*(size_t)tiles_n);
-	if (!tiles) {
-		fputs("Could not allocate memory for tiles\n", stderr);
-		fflush(stderr);
-		free(paint);
+	for (tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		unsigned y0, x0, h, w;
+		if (scanf("%ux%u;%ux%u", &y0, &x0, &h, &w) != 4) {
+			fputs("Invalid tile\n", stderr);
+			fflush(stderr);
+			free_data();
+			return EXIT_FAILURE;
+		}
+		set_tile(tiles+tile_idx, y0, x0, h, w);
+	}
+	if (!view_tiling(minimize_flag)) {
+		free_data();
 		return EXIT_FAILURE;
 	}
-	neighbours = malloc(sizeof(tile_t *)*(size_t)(tiles_n*(tiles_n-1U)/2U));
-	if (!neighbours) {
-		fputs("Could not allocate memory for neighbours\n", stderr);
+	free_data();
+	return EXIT_SUCCESS;
+}
+
+static int read_stream(int minimize_flag) {
+	unsigned height, width, stream_height = 0U, stream_width = 0U;
+	while (fgets(line, LINE_SIZE, stdin)) {
+		if (sscanf(line, "Square %ux%u", &height, &width) == 2 || sscanf(line, "Rectangle %ux%u", &height, &width) == 2 || sscanf(line, "Unique %ux%u", &height, &width) == 2) {
+			stream_height = height;
+			stream_width = width;
+			fputs(line, stdout);
+		}
+		else {
+			unsigned options_n;
+			if (sscanf(line, "0 %u %u %u", &height, &width, &options_n) == 3) {
+				if (stream_height) {
+					paint_height = stream_height;
+					paint_width = stream_width;
+				}
+				else {
+					paint_height = height;
+					paint_width = width;
+				}
+				if (!read_solution(height, width, options_n, minimize_flag)) {
+					return 0;
+				}
+			}
+		}
+	}
+	fflush(stdout);
+	return 1;
+}
+
+static int read_solution(unsigned height_max, unsigned width_max, unsigned options_n, int minimize_flag) {
+	int defect;
+	unsigned h, w;
+	if (!alloc_tiles(options_n)) {
+		return 0;
+	}
+	for (tiles_n = 0U; tiles_n < options_n; ++tiles_n) {
+		unsigned y0, x0;
+		if (!fgets(line, LINE_SIZE, stdin) || sscanf(line, "%ux%u;%ux%u", &y0, &x0, &h, &w) != 4) {
+			fputs("Invalid tile\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		set_tile(tiles+tiles_n, y0, x0, h, w);
+	}
+	if (!fgets(line, LINE_SIZE, stdin)) {
+		fputs("Unexpected end of solution\n", stderr);
 		fflush(stderr);
-		free(paint);
-		return EXIT_FAILURE;
+		return 0;
+	}
+	if (!strcmp(line, "Locks\n")) {
+		while (fgets(line, LINE_SIZE, stdin) && sscanf(line, "%ux%u", &h, &w) == 2) {
+			if (!alloc_tiles(tiles_n+1U)) {
+				return 0;
+			}
+			set_tile(tiles+tiles_n, 0U, 0U, h, w);
+			++tiles_n;
+		}
+	}
+	if (sscanf(line, "Defect %d", &defect) != 1) {
+		fputs("Expected Defect line at the end of solution\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	if (!paint_height || !paint_width || paint_height > SIZE_T_MAX/paint_width) {
+		fputs("Invalid paint\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	if (!place_locks(options_n, height_max, width_max)) {
+		fputs("Locks do not fit in paint\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	if (!view_tiling(minimize_flag)) {
+		return 0;
+	}
+	printf("Defect %d\n", defect);
+	return 1;
+}
+
+#include "mondrian_locks.h"
+
+static int alloc_tiles(unsigned tiles_max_min) {
+	unsigned tiles_max_tmp, *tiles_symbols_tmp, *colours_best_tiles_tmp;
+	tile_t *tiles_tmp, **tiles_sorted_tmp, **tiles_active_tmp;
+	if (tiles_max_min <= tiles_max) {
+		return 1;
+	}
+	tiles_max_tmp = tiles_max*2U > tiles_max_min ? tiles_max*2U:tiles_max_min;
+	tiles_tmp = realloc(tiles, sizeof(tile_t)*(size_t)tiles_max_tmp);
+	if (!tiles_tmp) {
+		fputs("Could not reallocate memory for tiles\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	tiles = tiles_tmp;
+	tiles_symbols_tmp = realloc(tiles_symbols, sizeof(unsigned)*(size_t)tiles_max_tmp);
+	if (!tiles_symbols_tmp) {
+		fputs("Could not reallocate memory for tiles_symbols\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	tiles_symbols = tiles_symbols_tmp;
+	colours_best_tiles_tmp = realloc(colours_best_tiles, sizeof(unsigned)*(size_t)tiles_max_tmp);
+	if (!colours_best_tiles_tmp) {
+		fputs("Could not reallocate memory for colours_best_tiles\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	colours_best_tiles = colours_best_tiles_tmp;
+	tiles_sorted_tmp = realloc(tiles_sorted, sizeof(tile_t *)*(size_t)tiles_max_tmp);
+	if (!tiles_sorted_tmp) {
+		fputs("Could not reallocate memory for tiles_sorted\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	tiles_sorted = tiles_sorted_tmp;
+	tiles_active_tmp = realloc(tiles_active, sizeof(tile_t *)*(size_t)tiles_max_tmp);
+	if (!tiles_active_tmp) {
+		fputs("Could not reallocate memory for tiles_active\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	tiles_active = tiles_active_tmp;
+	tiles_max = tiles_max_tmp;
+	return 1;
+}
+
+static int alloc_paint(unsigned paint_area) {
+	if (paint_area > paint_max) {
+		unsigned char *paint_tmp = realloc(paint, (size_t)paint_area);
+		if (!paint_tmp) {
+			fputs("Could not reallocate memory for paint\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		paint = paint_tmp;
+		paint_max = paint_area;
+	}
+	if (paint_width > row_max) {
+		unsigned *row_tmp = realloc(row, sizeof(unsigned)*(size_t)paint_width);
+		if (!row_tmp) {
+			fputs("Could not reallocate memory for row\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		row = row_tmp;
+		row_max = paint_width;
+	}
+	memset(paint, 0, (size_t)paint_area);
+	return 1;
+}
+
+static int view_tiling(int minimize_flag) {
+	unsigned paint_area = paint_height*paint_width, tiles_area_sum = 0U, tile_idx;
+	if (!alloc_paint(paint_area)) {
+		return 0;
 	}
-	neighbours_cur = neighbours;
-	tiles_area_sum = 0U;
 	for (tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
-		unsigned y0, x0, h, w, y;
-		if (scanf("%ux%u;%ux%u", &y0, &x0, &h, &w) != 4 || y0+h > paint_height || x0+w > paint_width) {
+		unsigned y;
+		if (tiles[tile_idx].y0 >= tiles[tile_idx].y1 || tiles[tile_idx].y1 > paint_height || tiles[tile_idx].x0 >= tiles[tile_idx].x1 || tiles[tile_idx].x1 > paint_width) {
 			fputs("Invalid tile\n", stderr);
 			fflush(stderr);
-			free(tiles);
-			free(paint);
-			return EXIT_FAILURE;
+			return 0;
 		}
-		for (y = y0; y < y0+h; ++y) {
+		for (y = tiles[tile_idx].y0; y < tiles[tile_idx].y1; ++y) {
 			unsigned x;
-			for (x = x0; x < x0+w; ++x) {
+			for (x = tiles[tile_idx].x0; x < tiles[tile_idx].x1; ++x) {
 				unsigned paint_idx = y*paint_width+x;
 				if (paint[paint_idx]) {
 					fprintf(stderr, "Overlap detected at %ux%u\n", y, x);
 					fflush(stderr);
-					free(tiles);
-					free(paint);
-					return EXIT_FAILURE;
+					return 0;
 				}
-				paint[paint_idx] = symbols[tile_idx];
+				paint[paint_idx] = 1U;
 			}
 		}
-		set_tile(tiles+tile_idx, y0, x0, h, w);
-		tiles_area_sum += h*w;
+		tiles_sorted[tile_idx] = tiles+tile_idx;
+		tiles_symbols[tile_idx] = tile_idx;
+		tiles_area_sum += (tiles[tile_idx].y1-tiles[tile_idx].y0)*(tiles[tile_idx].x1-tiles[tile_idx].x0);
 	}
 	if (tiles_area_sum < paint_area) {
 		fputs("Paint not fully covered\n", stderr);
 		fflush(stderr);
-		free(tiles);
-		free(paint);
-		return EXIT_FAILURE;
+		return 0;
 	}
+	qsort(tiles_sorted, (size_t)tiles_n, sizeof(tile_t *), compare_tiles);
 	if (minimize_flag) {
-		symbols_max = tiles_n;
-		try_symbol(0U, 0U);
+		if (!set_neighbours() || !set_colours()) {
+			return 0;
+		}
+		print_paint(tiles_symbols, colours_best);
 	}
 	else {
-		print_paint();
+		print_paint(tiles_symbols, tiles_n);
 	}
+	return 1;
+}
+
+static void free_data(void) {
+	free(colours_n);
+	free(neighbours);
+	free(edges);
+	free(tiles_active);
+	free(tiles_sorted);
+	free(colours_best_tiles);
+	free(tiles_symbols);
 	free(tiles);
+	free(row);
 	free(paint);
-	return EXIT_SUCCESS;
 }
 
-static void set_tile(tile_t *tile_a, unsigned y0, unsigned x0, unsigned h, unsigned w) {
-	tile_t *tile_b;
-	tile_a->y0 = y0;
-	tile_a->x0 = x0;
-	tile_a->y1 = y0+h;
-	tile_a->x1 = x0+w;
-	tile_a->neighbours_n = 0U;
-	tile_a->neighbours = neighbours_cur;
-	for (tile_b = tiles; tile_b < tile_a; ++tile_b) {
-		if (are_neighbours(tile_a, tile_b)) {
-			++tile_a->neighbours_n;
-			*neighbours_cur = tile_b;
-			++neighbours_cur;
+static void set_tile(tile_t *tile, unsigned y0, unsigned x0, unsigned h, unsigned w) {
+	tile->y0 = y0;
+	tile->x0 = x0;
+	tile->y1 = y0+h;
+	tile->x1 = x0+w;
+	tile->neighbours_n = 0U;
+	tile->colour = 0U;
+	tile->saturation = 0U;
+}
+
+static int set_neighbours(void) {
+	unsigned active_n, tile_idx, edge_idx;
+	edges_n = 0U;
+	for (active_n = 0U, tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		tile_t *tile = tiles_sorted[tile_idx];
+		unsigned active_idx, active_hi;
+		for (active_hi = 0U, active_idx = 0U; active_idx < active_n; ++active_idx) {
+			if (tiles_active[active_idx]->y1 >= tile->y0) {
+				tiles_active[active_hi++] = tiles_active[active_idx];
+				if (are_neighbours(tile, tiles_active[active_idx]) && !add_edge((unsigned)(tile-tiles), (unsigned)(tiles_active[active_idx]-tiles))) {
+					return 0;
+				}
+			}
 		}
+		tiles_active[active_hi] = tile;
+		active_n = active_hi+1U;
+	}
+	if (edges_n*2U > neighbours_max) {
+		tile_t **neighbours_tmp = realloc(neighbours, sizeof(tile_t *)*(size_t)edges_n*2U);
+		if (!neighbours_tmp) {
+			fputs("Could not reallocate memory for neighbours\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		neighbours = neighbours_tmp;
+		neighbours_max = edges_n*2U;
+	}
+	for (edge_idx = 0U; edge_idx < edges_n*2U; ++edge_idx) {
+		++tiles[edges[edge_idx]].neighbours_n;
+	}
+	for (edge_idx = 0U, tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		tiles[tile_idx].neighbours = neighbours+edge_idx;
+		edge_idx += tiles[tile_idx].neighbours_n;
+		tiles[tile_idx].neighbours_n = 0U;
+	}
+	for (edge_idx = 0U; edge_idx < edges_n*2U; edge_idx += 2U) {
+		tile_t *tile_a = tiles+edges[edge_idx], *tile_b = tiles+edges[edge_idx+1U];
+		tile_a->neighbours[tile_a->neighbours_n++] = tile_b;
+		tile_b->neighbours[tile_b->neighbours_n++] = tile_a;
 	}
-	tile_a->symbol = 0U;
+	return 1;
+}
+
+static int compare_tiles(const void *a, const void *b) {
+	const tile_t *tile_a = *(tile_t * const *)a, *tile_b = *(tile_t * const *)b;
+	if (tile_a->y0 != tile_b->y0) {
+		return tile_a->y0 < tile_b->y0 ? -1:1;
+	}
+	return tile_a->x0 < tile_b->x0 ? -1:1;
+}
+
+static int add_edge(unsigned tile_a, unsigned tile_b) {
+	if (edges_n == edges_max) {
+		unsigned edges_max_tmp = edges_max ? edges_max*2U:EDGES_MIN, *edges_tmp;
+		if (edges_max_tmp < edges_max) {
+			fputs("Too many neighbours\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		edges_tmp = realloc(edges, sizeof(unsigned)*(size_t)edges_max_tmp*2U);
+		if (!edges_tmp) {
+			fputs("Could not reallocate memory for edges\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		edges = edges_tmp;
+		edges_max = edges_max_tmp;
+	}
+	edges[edges_n*2U] = tile_a;
+	edges[edges_n*2U+1U] = tile_b;
+	++edges_n;
+	return 1;
 }
 
 static int are_neighbours(const tile_t *tile_a, const tile_t *tile_b) {
@@ -141,49 +411,171 @@ static int are_neighbours(const tile_t *tile_a, const tile_t *tile_b) {
 	return (tile_a->y0 == tile_b->y1 && tile_a->x0 <= tile_b->x1) || (tile_a->y0 <= tile_b->y1 && tile_a->x0 == tile_b->x1);
 }
 
-static void try_symbol(unsigned tiles_hi, unsigned symbols_hi) {
-	unsigned symbol_idx;
-	if (symbols_hi >= symbols_max) {
-		return;
+static int set_colours(void) {
+	unsigned tile_idx, colour;
+	colours_max = 0U;
+	for (tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		unsigned neighbour_idx;
+		for (colour = 1U; colour <= tiles_n; ++colour) {
+			for (neighbour_idx = 0U; neighbour_idx < tiles[tile_idx].neighbours_n && tiles[tile_idx].neighbours[neighbour_idx]->colour != colour; ++neighbour_idx);
+			if (neighbour_idx == tiles[tile_idx].neighbours_n) {
+				break;
+			}
+		}
+		tiles[tile_idx].colour = colour;
+		tiles_symbols[tile_idx] = colour-1U;
+		if (colour > colours_max) {
+			colours_max = colour;
+		}
+	}
+	colours_best = colours_max;
+	set_colours_lo();
+	if (colours_best == colours_lo) {
+		return 1;
 	}
+	if ((size_t)tiles_n > SIZE_T_MAX/sizeof(unsigned)/colours_max) {
+		fputs("Will not be able to allocate memory for colours_n\n", stderr);
+		fflush(stderr);
+		return 0;
+	}
+	if (tiles_n*colours_max > colours_n_max) {
+		unsigned *colours_n_tmp = realloc(colours_n, sizeof(unsigned)*(size_t)tiles_n*colours_max);
+		if (!colours_n_tmp) {
+			fputs("Could not reallocate memory for colours_n\n", stderr);
+			fflush(stderr);
+			return 0;
+		}
+		colours_n = colours_n_tmp;
+		colours_n_max = tiles_n*colours_max;
+	}
+	memset(colours_n, 0, sizeof(unsigned)*(size_t)tiles_n*colours_max);
+	for (tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		tiles[tile_idx].colour = 0U;
+		tiles[tile_idx].colours_n = colours_n+tile_idx*colours_max;
+		colours_best_tiles[tile_idx] = tiles_symbols[tile_idx];
+	}
+	nodes_n = 0UL;
+	try_colour(0U, 0U);
+	for (colour = 0U, tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+		unsigned *symbol = colours_n+colours_best_tiles[tile_idx];
+		if (!*symbol) {
+			*symbol = ++colour;
+		}
+		tiles_symbols[tile_idx] = *symbol-1U;
+	}
+	return 1;
+}
+
+static void set_colours_lo(void) {
+	unsigned tile_idx;
+	colours_lo = 1U;
+	for (tile_idx = 0U; tile_idx < tiles_n && colours_lo < colours_best; ++tile_idx) {
+		unsigned clique_n = 1U, neighbour_idx;
+		tile_t *clique[4];
+		clique[0] = tiles+tile_idx;
+		for (neighbour_idx = 0U; neighbour_idx < tiles[tile_idx].neighbours_n && clique_n < 4U; ++neighbour_idx) {
+			unsigned clique_idx;
+			for (clique_idx = 1U; clique_idx < clique_n && are_neighbours(tiles[tile_idx].neighbours[neighbour_idx], clique[clique_idx]); ++clique_idx);
+			if (clique_idx == clique_n) {
+				clique[clique_n++] = tiles[tile_idx].neighbours[neighbour_idx];
+			}
+		}
+		if (clique_n > colours_lo) {
+			colours_lo = clique_n;
+		}
+	}
+	if (colours_lo < 4U && colours_lo < colours_best) {
+		for (tile_idx = 0U; tile_idx < tiles_n && (!tiles[tile_idx].y0 || !tiles[tile_idx].x0 || tiles[tile_idx].y1 == paint_height || tiles[tile_idx].x1 == paint_width || tiles[tile_idx].neighbours_n%2U == 0U); ++tile_idx);
+		if (tile_idx < tiles_n) {
+			colours_lo = 4U;
+		}
+	}
+}
+
+static void try_colour(unsigned tiles_hi, unsigned colours_hi) {
+	unsigned colour;
+	tile_t *tile;
 	if (tiles_hi == tiles_n) {
-		symbols_max = symbols_hi;
-		print_paint();
+		unsigned tile_idx;
+		colours_best = colours_hi;
+		for (tile_idx = 0U; tile_idx < tiles_n; ++tile_idx) {
+			colours_best_tiles[tile_idx] = tiles[tile_idx].colour-1U;
+		}
 		return;
 	}
-	for (symbol_idx = symbols_hi+1U; symbol_idx--; ) {
-		unsigned neighbour_idx;
-		for (neighbour_idx = 0U; neighbour_idx < tiles[tiles_hi].neighbours_n && tiles[tiles_hi].neighbours[neighbour_idx]->symbol != symbols[symbol_idx]; ++neighbour_idx);
-		if (neighbour_idx == tiles[tiles_hi].neighbours_n) {
-			set_symbol(tiles+tiles_hi, symbols[symbol_idx]);
-			try_symbol(tiles_hi+1U, symbols_hi);
-			tiles[tiles_hi].symbol = 0;
+	++nodes_n;
+	tile = get_tile_max();
+	for (colour = 0U; colour < colours_hi && colours_hi < colours_best && colours_best > colours_lo && nodes_n < NODES_MAX; ++colour) {
+		if (!tile->colours_n[colour]) {
+			set_colour(tile, colour);
+			try_colour(tiles_hi+1U, colours_hi);
+			unset_colour(tile);
 		}
 	}
-	if (tiles_hi > symbols_hi) {
-		set_symbol(tiles+tiles_hi, symbols[symbols_hi+1U]);
-		try_symbol(tiles_hi+1U, symbols_hi+1U);
-		tiles[tiles_hi].symbol = 0;
+	if (colours_hi+1U < colours_best && colours_best > colours_lo && nodes_n < NODES_MAX) {
+		set_colour(tile, colours_hi);
+		try_colour(tiles_hi+1U, colours_hi+1U);
+		unset_colour(tile);
 	}
 }
 
-static void set_symbol(tile_t *tile, int symbol) {
-	unsigned y;
-	for (y = tile->y0; y < tile->y1; ++y) {
-		unsigned x;
-		for (x = tile->x0; x < tile->x1; ++x) {
-			paint[y*paint_width+x] = symbol;
+static tile_t *get_tile_max(void) {
+	tile_t *tile_max = NULL, *tile;
+	for (tile = tiles; tile < tiles+tiles_n; ++tile) {
+		if (!tile->colour && (!tile_max || tile->saturation > tile_max->saturation || (tile->saturation == tile_max->saturation && tile->neighbours_n > tile_max->neighbours_n))) {
+			tile_max = tile;
 		}
 	}
-	tile->symbol = symbol;
+	return tile_max;
 }
 
-static void print_paint(void) {
-	unsigned y;
-	for (y = 0U; y < paint_height; ++y) {
-		unsigned x;
+static void set_colour(tile_t *tile, unsigned colour) {
+	unsigned neighbour_idx;
+	tile->colour = colour+1U;
+	for (neighbour_idx = 0U; neighbour_idx < tile->neighbours_n; ++neighbour_idx) {
+		tile_t *neighbour = tile->neighbours[neighbour_idx];
+		if (!neighbour->colours_n[colour]++) {
+			++neighbour->saturation;
+		}
+	}
+}
+
+static void unset_colour(tile_t *tile) {
+	unsigned colour = tile->colour-1U, neighbour_idx;
+	for (neighbour_idx = 0U; neighbour_idx < tile->neighbours_n; ++neighbour_idx) {
+		tile_t *neighbour = tile->neighbours[neighbour_idx];
+		if (!--neighbour->colours_n[colour]) {
+			--neighbour->saturation;
+		}
+	}
+	tile->colour = 0U;
+}
+
+static void print_paint(const unsigned *paint_symbols, unsigned symbols_n) {
+	unsigned symbol_len, symbols_max, active_n, tile_idx, y;
+	for (symbol_len = 1U, symbols_max = SYMBOLS_N; symbols_max < symbols_n; ++symbol_len, symbols_max *= SYMBOLS_N);
+	for (active_n = 0U, tile_idx = 0U, y = 0U; y < paint_height; ++y) {
+		unsigned active_idx, active_hi, x;
+		for (active_hi = 0U, active_idx = 0U; active_idx < active_n; ++active_idx) {
+			if (tiles_active[active_idx]->y1 > y) {
+				tiles_active[active_hi++] = tiles_active[active_idx];
+			}
+		}
+		for (; tile_idx < tiles_n && tiles_sorted[tile_idx]->y0 == y; ++tile_idx) {
+			tiles_active[active_hi++] = tiles_sorted[tile_idx];
+		}
+		active_n = active_hi;
+		for (active_idx = 0U; active_idx < active_n; ++active_idx) {
+			for (x = tiles_active[active_idx]->x0; x < tiles_active[active_idx]->x1; ++x) {
+				row[x] = paint_symbols[tiles_active[active_idx]-tiles];
+			}
+		}
 		for (x = 0U; x < paint_width; ++x) {
-			putchar(paint[y*paint_width+x]);
+			unsigned symbol_div = symbols_max, symbol_idx;
+			for (symbol_idx = 0U; symbol_idx < symbol_len; ++symbol_idx) {
+				symbol_div /= SYMBOLS_N;
+				putchar(symbols[row[x]/symbol_div%SYMBOLS_N]);
+			}
 		}
 		puts("");
 	}
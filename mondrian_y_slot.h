@@ -0,0 +1,233 @@
+static int Y_SLOT_SEARCH(int bars_hi, bar_t *bar_start, option_t *options_start) {
+	int r, i;
+	unsigned long nodes_start;
+	double time_start;
+	if (++nodes_n > nodes_max && !is_in_budget()) {
+		return 0;
+	}
+	if (verbose_flag) {
+		mp_inc(y_cost);
+	}
+	if (bars_hi < bars_n) {
+		TELEMETRY(add_prune(PRUNE_BARS, y_depth));
+		return 0;
+	}
+	if (bar_start != bars_header) {
+		int y_slot = bar_start->y_slot, slot_width = bar_start->x_space, x_max, y_min;
+		option_t *option, *last_chance;
+		bar_t *bar_cur, *bar_cur_next, *bar_start_next, *bar;
+		if (bars_hi == bars_n) {
+			for (option = options_start; option != options_header; option = option->y_next) {
+				if (option->yh_slot_max < y_slot) {
+					TELEMETRY(add_prune(PRUNE_Y_SLOT, y_depth));
+					return 0;
+				}
+				if (option->width == slot_width) {
+					if (check_next_y_slot(bar_start, y_slot+option->height) && Y_SLOT_CHOOSE(bars_hi, bar_start, option, option->height, option->width)) {
+						return 1;
+					}
+				}
+				else if (Y_SLOT_ROTATE(option) && option->yw_slot_max >= y_slot && option->height == slot_width && check_next_y_slot(bar_start, y_slot+option->width) && Y_SLOT_CHOOSE(bars_hi, bar_start, option, option->width, option->height)) {
+					return 1;
+				}
+			}
+			return 0;
+		}
+		if (bars_hi == bars_n+1) {
+			for (option = options_start; option != options_header; option = option->y_next) {
+				if (option->yh_slot_max < y_slot) {
+					TELEMETRY(add_prune(PRUNE_Y_SLOT, y_depth));
+					return 0;
+				}
+				if (((option->width == slot_width || (option->width < slot_width && check_next_y_slot(bar_start, y_slot+option->height))) && Y_SLOT_CHOOSE(bars_hi, bar_start, option, option->height, option->width)) || (Y_SLOT_ROTATE(option) && option->yw_slot_max >= y_slot && (option->height == slot_width || (option->height < slot_width && check_next_y_slot(bar_start, y_slot+option->width))) && Y_SLOT_CHOOSE(bars_hi, bar_start, option, option->width, option->height))) {
+					return 1;
+				}
+			}
+			return 0;
+		}
+		x_max = 0;
+		y_min = height_max;
+		for (option = options_start; option != options_header; option = option->y_next) {
+			if (option->yh_slot_max < y_slot) {
+				TELEMETRY(add_prune(PRUNE_Y_SLOT, y_depth));
+				return 0;
+			}
+			if (option->width <= slot_width) {
+				x_max += option->width;
+				if (option->height < y_min) {
+					y_min = option->height;
+				}
+			}
+			else if (Y_SLOT_ROTATE(option) && option->yw_slot_max >= y_slot && option->height <= slot_width) {
+				x_max += option->height;
+				if (option->width < y_min) {
+					y_min = option->width;
+				}
+			}
+		}
+		if (x_max < slot_width) {
+			TELEMETRY(add_prune(PRUNE_X_MAX, y_depth));
+			return 0;
+		}
+		for (bar_cur = bar_start; bar_cur != bars_header && bar_cur->height <= y_min; bar_cur = bar_cur->next) {
+			y_min -= bar_cur->height;
+			bar_cur->x_space -= slot_width;
+		}
+		bar_cur_next = bar_cur->next;
+		if (y_min) {
+			set_bar(bars+bars_n, bar_cur->y_slot+y_min, bar_cur->height-y_min, bar_cur->x_space);
+			bar_cur->x_space -= slot_width;
+			insert_bar(bars+bars_n, bar_cur, bar_cur_next);
+		}
+		bar_start_next = bar_start->next;
+		if (masks_flag) {
+			unsigned long fits = 0UL, lost;
+			for (bar = bar_start_next; bar != bars_header; bar = bar->next) {
+				fits |= get_fits(bar->y_slot, bar->x_space);
+			}
+			lost = y_options & ~fits;
+			if (lost & (get_low_mask((int)(options_start-options)) | ~(width_fits[slot_width] | (yw_fits[y_slot] & height_fits[slot_width])))) {
+				rollback_y_slot(bar_start, bar_cur, bar_cur_next, y_min, slot_width);
+				TELEMETRY(add_prune(PRUNE_OPTION, y_depth));
+				return 0;
+			}
+			last_chance = lost ? options+get_low_bit(lost):options_header;
+		}
+		else {
+			last_chance = options_header;
+			for (option = options_header->y_next; option != options_header; option = option->y_next) {
+				if (Y_SLOT_ROTATE(option)) {
+					for (bar = bar_start_next; bar != bars_header && bar->x_space < option->height; bar = bar->next);
+					if (bar == bars_header || bar->y_slot > option->yw_slot_max) {
+						for (; bar != bars_header && bar->x_space < option->width; bar = bar->next);
+						if (bar == bars_header || bar->y_slot > option->yh_slot_max) {
+							if (option < options_start || ((option->yw_slot_max < y_slot || option->height > slot_width) && option->width > slot_width)) {
+								rollback_y_slot(bar_start, bar_cur, bar_cur_next, y_min, slot_width);
+								TELEMETRY(add_prune(PRUNE_OPTION, y_depth));
+								return 0;
+							}
+							if (option < last_chance) {
+								last_chance = option;
+							}
+						}
+					}
+				}
+				else {
+					for (bar = bar_start_next; bar != bars_header && bar->x_space < option->width; bar = bar->next);
+					if (bar == bars_header || bar->y_slot > option->yh_slot_max) {
+						if (option < options_start || option->width > slot_width) {
+							rollback_y_slot(bar_start, bar_cur, bar_cur_next, y_min, slot_width);
+							TELEMETRY(add_prune(PRUNE_OPTION, y_depth));
+							return 0;
+						}
+						if (option < last_chance) {
+							last_chance = option;
+						}
+					}
+				}
+			}
+		}
+		rollback_y_slot(bar_start, bar_cur, bar_cur_next, y_min, slot_width);
+		for (bar = bar_start->next; bar != bars_header; bar = bar->next) {
+			if (!Y_SLOT_FILL(bar)) {
+				TELEMETRY(add_prune(PRUNE_BAR, y_depth));
+				return 0;
+			}
+		}
+		for (option = options_start; option != options_header; option = option->y_next) {
+			if (option->width <= slot_width) {
+				if ((Y_SLOT_CHOOSE(bars_hi, bar_start, option, option->height, option->width)) || (Y_SLOT_ROTATE(option) && option->yw_slot_max >= y_slot && option->height <= slot_width && Y_SLOT_CHOOSE(bars_hi, bar_start, option, option->width, option->height))) {
+					return 1;
+				}
+				x_max -= option->width;
+			}
+			else if (Y_SLOT_ROTATE(option) && option->yw_slot_max >= y_slot && option->height <= slot_width) {
+				if (Y_SLOT_CHOOSE(bars_hi, bar_start, option, option->width, option->height)) {
+					return 1;
+				}
+				x_max -= option->height;
+			}
+			if (x_max < slot_width) {
+				TELEMETRY(add_prune(PRUNE_X_MAX, y_depth));
+				return 0;
+			}
+			if (option == last_chance) {
+				TELEMETRY(add_prune(PRUNE_LAST_CHANCE, y_depth));
+				return 0;
+			}
+		}
+		return 0;
+	}
+	for (i = options_n; i--; ) {
+		set_option(options+i);
+		link_options_x(options+i, options+i+1);
+	}
+	link_options_x(options_header, options);
+	set_rows();
+	solutions_n = 0;
+	if (verbose_flag) {
+		mp_new(x_cost);
+	}
+	set_ledge(0, width_max, 0);
+	insert_choice(choices, choices_header, choices_header);
+	choices_hi = choices;
+	nodes_start = nodes_n;
+	time_start = get_time();
+	TELEMETRY(set_branches(PHASE_X, 0));
+	r = search_x_slot(choices);
+	TELEMETRY(close_branches(PHASE_X, 0));
+	stats.x_nodes_n += nodes_n-nodes_start;
+	stats.x_seconds += get_time()-time_start;
+	link_choices(choices_header, choices_header);
+	if (verbose_flag) {
+		mp_print("search_x_slot cost", x_cost);
+	}
+	return r;
+}
+
+static int Y_SLOT_FILL(const bar_t *bar) {
+	option_t *option;
+	if (masks_flag) {
+		return (y_options & get_fits(bar->y_slot, bar->x_space)) != 0UL;
+	}
+	for (option = options_header->y_next; option != options_header && (option->yh_slot_max < bar->y_slot || option->width > bar->x_space) && (!Y_SLOT_ROTATE(option) || option->yw_slot_max < bar->y_slot || option->height > bar->x_space); option = option->y_next);
+	return option != options_header;
+}
+
+static int Y_SLOT_CHOOSE(int bars_hi, bar_t *bar_start, option_t *option, int slot_height, int slot_width) {
+	int r;
+	bar_t *bar_cur, *bar;
+	TELEMETRY(add_branch(PHASE_Y, y_depth));
+	option->slot_height = slot_height;
+	option->y_slot_lo = bar_start->y_slot;
+	link_options_y(option->y_last, option->y_next);
+	y_options ^= option->bit;
+	for (bar_cur = bar_start; bar_cur != bars_header && bar_cur->height <= slot_height; bar_cur = bar_cur->next) {
+		slot_height -= bar_cur->height;
+		bar_cur->x_space -= slot_width;
+	}
+	bar = bar_cur->next;
+	if (slot_height) {
+		set_bar(bars+bars_n, bar_cur->y_slot+slot_height, bar_cur->height-slot_height, bar_cur->x_space);
+		bar_cur->height = slot_height;
+		bar_cur->x_space -= slot_width;
+		insert_bar(bars+bars_n, bar_cur, bar);
+		++bars_n;
+	}
+	TELEMETRY(set_branches(PHASE_Y, ++y_depth));
+	r = bar_start->x_space ? Y_SLOT_SEARCH(bars_hi-1, bar_start, option->y_next):Y_SLOT_SEARCH(bars_hi, bar_start->next, options_header->y_next);
+	TELEMETRY(close_branches(PHASE_Y, y_depth--));
+	if (slot_height) {
+		--bars_n;
+		link_bars(bar_cur, bar);
+		bar_cur->x_space += slot_width;
+		bar_cur->height += bars[bars_n].height;
+	}
+	for (bar = bar_start; bar != bar_cur; bar = bar->next) {
+		bar->x_space += slot_width;
+	}
+	y_options ^= option->bit;
+	option->y_next->y_last = option;
+	option->y_last->y_next = option;
+	return r;
+}